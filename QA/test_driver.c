@@ -0,0 +1,253 @@
+/**
+ * @file test_driver.c
+ * @brief test driver: assembles sources which are built by the test cases with the assembler library, and checks
+ * their errors and words against the expected ones. the edits of a session are checked against assembling the whole
+ * edited source.
+ *
+ * usage: test_driver
+ * prints a line per test case, and exits with 1 if any of them failed.
+ */
+
+#include "../assembler.h"
+#include "../session.h"
+#include "../utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define TEST_LOAD_BASE 100                                 /* the load base of the memory tests */
+#define TEST_MEMORY_SIZE 110                               /* the memory of the memory tests: 10 words */
+#define SESSION_TEST_LINES (3 * SESSION_BLOCK_LINES + 500) /* lines of the session tests, over 4 blocks */
+#define SESSION_TEST_STEP 64                               /* lines between labels, and between jumps */
+#define SESSION_TEST_LINE_LENGTH 32                        /* the longest line of the session tests */
+
+/* an edit of a session test: replace a range of lines with a text */
+typedef struct {
+    char *name;     /* the name of the test case */
+    long first;     /* index of the first line to replace */
+    long num_lines; /* number of lines to replace */
+    char *text;     /* the new lines */
+    int repeat;     /* number of times the text is repeated */
+} session_test_edit;
+
+/* Prototypes */
+static bool test_memory(char *name, char *lines[], int num_lines, int repeat, int error_line);
+static void test_session(char *name, char *header, session_test_edit *edits, int num_edits);
+static bool compare_session(char *name, assembly_session *s, assembler_ctx *ctx);
+static void session_source(text_buffer *src, char *header);
+static void repeat_lines(text_buffer *src, char *lines[], int num_lines, int repeat);
+static bool check(char *name, bool passed, char *message);
+
+static int num_failed = 0;
+
+int main() {
+    char *code_lines[] = {"hlt\n"};
+    char *data_lines[] = {"hlt\n", "hlt\n", "hlt\n", "hlt\n", "hlt\n", "LIST: .data 1,2,3\n", ".data 4,5,6\n",
+                          ".data 7,8,9\n", "hlt\n"};
+    char *string_lines[] = {"hlt\n", "hlt\n", "STR: .string \"abcdefghij\"\n", ".data 1\n"};
+    session_test_edit edits[] = {
+        {"session: replace a line", 5000, 1, "inc r3\n", 1},
+        {"session: insert lines across a block boundary", SESSION_BLOCK_LINES - 10, 0, "prn #1\n", 20},
+        {"session: delete lines across a block boundary", 2 * SESSION_BLOCK_LINES - 15, 30, "", 0},
+        {"session: a duplicate label in another block", 9000, 0, "L0: hlt\n", 1},
+        {"session: remove the duplicate label", 9000, 1, "", 0},
+        {"session: rename a label which another block jumps to", 64, 1, "M64: mov r1, r2\n", 1},
+        {"session: rename the label back", 64, 1, "L64: mov r1, r2\n", 1},
+        {"session: a label before .extern of it", 100, 0, ".extern L9664\n", 1},
+        {"session: remove the .extern", 100, 1, "", 0},
+        {"session: .entry of a label of another block", 3000, 0, ".entry L9600\n", 1},
+        {"session: .entry of a missing label", 3001, 0, ".entry NOPE\n", 1},
+        {"session: a comment which mentions a macro", 20, 1, "; a macro here\n", 1},
+        {"session: overflow the memory", 6000, 0, "mov r1, L0\n", 200},
+        {"session: fit in the memory again", 6000, 200, "", 0},
+        {"session: append lines", SESSION_TEST_LINES + 100, 0, "END: hlt\n", 1},
+        {"session: replace the lines of 2 blocks", 4000, SESSION_BLOCK_LINES + 300, "sub r1, r2\n", 10}};
+    session_test_edit macro_edits[] = {
+        {"session with macros: use the macro across a block boundary", SESSION_BLOCK_LINES - 2, 0, "m1\n", 5},
+        {"session with macros: change the content of the macro", 1, 1, "inc r2\nclr r3\n", 1},
+        {"session with macros: an error in the macro", 2, 1, "clr #3\n", 1},
+        {"session with macros: a label in the macro", 2, 1, "M1: clr r3\n", 1},
+        {"session with macros: remove the definition", 0, 4, "", 0},
+        {"session with macros: define it again", 0, 0, "macro m1\ninc r4\nendmacro\n", 1}};
+
+    test_memory("memory: fits exactly", code_lines, 1, 10, 0);
+    test_memory("memory: overflow in the instructions", code_lines, 1, 30, 11);
+    test_memory("memory: overflow in the data", data_lines, 9, 1, 7);
+    test_memory("memory: overflow in a string", string_lines, 4, 1, 3);
+    test_session("session: load", "", edits, sizeof(edits) / sizeof(edits[0]));
+    test_session("session with macros: load", "macro m1\ninc r2\nendmacro\nm1\n", macro_edits,
+                 sizeof(macro_edits) / sizeof(macro_edits[0]));
+
+    printf("%d test cases failed\n", num_failed);
+    return num_failed > 0;
+}
+
+/**
+ * @brief assembles a source in a memory of TEST_MEMORY_SIZE addresses from TEST_LOAD_BASE, and checks that it fits,
+ * or that the memory overflow is reported exactly once, on the first line which crossed the end of the memory.
+ *
+ * @param name the name of the test case
+ * @param lines the lines of the source
+ * @param num_lines number of lines
+ * @param repeat number of times the lines are repeated in the source
+ * @param error_line the line (from 1) which overflows the memory, 0 if the program fits
+ * @return true if the test case passed, otherwise false.
+ */
+static bool test_memory(char *name, char *lines[], int num_lines, int repeat, int error_line) {
+    assembler_ctx *ctx;
+    assembly_result result;
+    text_buffer src;
+    bool passed;
+
+    text_buffer_init(&src);
+    repeat_lines(&src, lines, num_lines, repeat);
+    ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+    assembler_init(ctx);
+    ctx->load_base = TEST_LOAD_BASE;
+    ctx->memory_size = TEST_MEMORY_SIZE;
+
+    assemble_buffer(ctx, src.data, src.length, &result);
+    if (error_line == 0)
+        passed = check(name, result.has_output && result.num_diagnostics == 0, "the program doesn't fit");
+    else
+        passed = check(name,
+                       !result.has_output && result.num_diagnostics == 1 &&
+                           result.diagnostics[0].code == ERR_MEMORY_OVERFLOW &&
+                           result.diagnostics[0].line_num == error_line,
+                       "the overflow isn't reported once on its line");
+
+    assembly_result_free(&result);
+    assembler_free(ctx);
+    free(ctx);
+    text_buffer_free(&src);
+    return passed;
+}
+
+/**
+ * @brief loads a source of SESSION_TEST_LINES lines to a session and applies edits to it, and checks the session
+ * after loading and after each edit against assembling the whole source.
+ *
+ * @param name the name of the test case of loading the source
+ * @param header lines at the start of the source (e.g. the definition of a macro)
+ * @param edits the edits, by their order
+ * @param num_edits number of edits
+ */
+static void test_session(char *name, char *header, session_test_edit *edits, int num_edits) {
+    assembler_ctx *ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+    assembly_session s;
+    text_buffer src;
+    int i;
+
+    assembler_init(ctx);
+    session_init(&s);
+    text_buffer_init(&src);
+    session_source(&src, header);
+    session_load(&s, src.data, src.length);
+    compare_session(name, &s, ctx);
+
+    for (i = 0; i < num_edits; i++) {
+        src.length = 0;
+        repeat_lines(&src, &edits[i].text, 1, edits[i].repeat);
+        session_edit(&s, edits[i].first, edits[i].num_lines, src.data, src.length);
+        compare_session(edits[i].name, &s, ctx);
+    }
+
+    text_buffer_free(&src);
+    session_free(&s);
+    assembler_free(ctx);
+    free(ctx);
+}
+
+/**
+ * @brief checks that the result of a session is the same as assembling its whole source
+ *
+ * @param name the name of the test case
+ * @param s the session
+ * @param ctx a context to assemble the source with
+ * @return true if the test case passed, otherwise false.
+ */
+static bool compare_session(char *name, assembly_session *s, assembler_ctx *ctx) {
+    text_buffer *src = &s->source[s->current];
+    assembly_result result;
+    bool passed;
+    int i;
+
+    assemble_buffer(ctx, src->data, src->length, &result);
+    passed = result.num_diagnostics == s->num_diagnostics && ctx->diagnostics.dropped == s->dropped_diagnostics &&
+             result.has_output == s->has_output;
+    for (i = 0; passed && i < s->num_diagnostics; i++)
+        passed = result.diagnostics[i].code == s->diagnostics[i].code &&
+                 result.diagnostics[i].line_num == s->diagnostics[i].line_num &&
+                 result.diagnostics[i].column == s->diagnostics[i].column;
+    if (passed && result.has_output)
+        passed = ctx->ic == s->code_size && ctx->dc == s->data_size &&
+                 !memcmp(ctx->instr_memory.words, s->code, s->code_size * sizeof(machine_word)) &&
+                 !memcmp(ctx->data_memory.words, s->data, s->data_size * sizeof(machine_word));
+    assembly_result_free(&result);
+    return check(name, passed, "the session isn't the same as assembling the whole source");
+}
+
+/**
+ * @brief makes the source of the session tests: a label every SESSION_TEST_STEP lines, which is jumped to from a
+ * line of another block, and comments between them (so the program fits in the memory). the source ends with
+ * an .entry, an .extern and data.
+ *
+ * @param src the source
+ * @param header lines at the start of the source
+ */
+static void session_source(text_buffer *src, char *header) {
+    long num_labels = SESSION_TEST_LINES / SESSION_TEST_STEP;
+    char line[SESSION_TEST_LINE_LENGTH];
+    char *footer = ".entry L0\n.extern EXT\njsr EXT\nDATA: .data 1,2,3\n";
+    long i;
+
+    text_buffer_append(src, header, strlen(header));
+    for (i = 0; i < SESSION_TEST_LINES; i++) {
+        if (i % SESSION_TEST_STEP == 0)
+            sprintf(line, "L%ld: mov r1, r2\n", i);
+        else if (i % SESSION_TEST_STEP == SESSION_TEST_STEP / 2)
+            sprintf(line, "jmp L%ld\n", (i / SESSION_TEST_STEP + num_labels / 2) % num_labels * SESSION_TEST_STEP);
+        else if (i % 2 == 0)
+            sprintf(line, "; line %ld\n", i);
+        else
+            strcpy(line, "\n");
+        text_buffer_append(src, line, strlen(line));
+    }
+    text_buffer_append(src, footer, strlen(footer));
+}
+
+/**
+ * @brief appends lines to a source a number of times
+ *
+ * @param src the source
+ * @param lines the lines to append
+ * @param num_lines number of lines
+ * @param repeat number of times to append them
+ */
+static void repeat_lines(text_buffer *src, char *lines[], int num_lines, int repeat) {
+    int i, j;
+
+    for (i = 0; i < repeat; i++) {
+        for (j = 0; j < num_lines; j++)
+            text_buffer_append(src, lines[j], strlen(lines[j]));
+    }
+}
+
+/**
+ * @brief prints the result of a test case
+ *
+ * @param name the name of the test case
+ * @param passed true if the test case passed
+ * @param message the reason of a failure
+ * @return the given passed
+ */
+static bool check(char *name, bool passed, char *message) {
+    if (passed)
+        printf("PASS %s\n", name);
+    else {
+        printf("FAIL %s: %s\n", name, message);
+        num_failed++;
+    }
+    return passed;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file arena.c
+ * @brief this file includes a bump-pointer allocator for the temporaries of a single source (such as the names of
+ * its files and the arrays of the threads which compile it). an allocation takes the next bytes of the current
+ * block, and nothing is freed by itself: the whole arena is reset when the source is done, and keeps its memory for
+ * the next source. a reset merges the blocks to a single block, so the following sources are served from a single
+ * allocation, and a long batch of files doesn't fragment the heap.
+ */
+
+#include "arena.h"
+
+/* Prototypes */
+static void add_block(arena *a, long size);
+
+/**
+ * @brief initialize an empty arena, its first block is allocated by the first allocation
+ *
+ * @param a the arena to initialize
+ */
+void arena_init(arena *a) {
+    a->blocks = NULL;
+    a->total = 0;
+}
+
+/**
+ * @brief allocates a new block, which becomes the current block
+ *
+ * @param a the arena
+ * @param size the number of bytes of the block (w/o its header)
+ */
+static void add_block(arena *a, long size) {
+    arena_block *block = (arena_block *)malloc_w_check(ARENA_ALIGN((long)sizeof(arena_block)) + size);
+
+    block->next = a->blocks;
+    block->size = size;
+    block->used = 0;
+    a->blocks = block;
+    a->total += size;
+}
+
+/**
+ * @brief allocates memory from the arena, which is valid until the arena is reset
+ *
+ * @param a the arena
+ * @param size the number of bytes to allocate
+ * @return void* pointer to the memory
+ */
+void *arena_alloc(arena *a, long size) {
+    arena_block *block = a->blocks;
+    long new_size;
+    void *ptr;
+
+    size = ARENA_ALIGN(size);
+    if (block == NULL || block->used + size > block->size) {
+        /* a new block is at least as large as all the previous blocks, so the number of blocks stays small */
+        new_size = a->total > ARENA_BLOCK_SIZE ? a->total : ARENA_BLOCK_SIZE;
+        add_block(a, size > new_size ? size : new_size);
+        block = a->blocks;
+    }
+
+    ptr = (char *)block + ARENA_ALIGN((long)sizeof(arena_block)) + block->used;
+    block->used += size;
+    return ptr;
+}
+
+/**
+ * @brief releases all the allocations of the arena at once. when the arena has several blocks, they are replaced
+ * by a single block of their total size, which is enough for the same allocations.
+ *
+ * @param a the arena to reset
+ */
+void arena_reset(arena *a) {
+    long total = a->total;
+
+    if (a->blocks != NULL && a->blocks->next != NULL) {
+        arena_free(a);
+        add_block(a, total);
+    } else if (a->blocks != NULL)
+        a->blocks->used = 0;
+}
+
+/**
+ * @brief free memory allocation of a given arena
+ *
+ * @param a the arena to free
+ */
+void arena_free(arena *a) {
+    arena_block *block;
+
+    while (a->blocks != NULL) {
+        block = a->blocks;
+        a->blocks = block->next;
+        free(block);
+    }
+    a->total = 0;
+}
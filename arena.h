@@ -0,0 +1,21 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "global.h"
+#include "utils.h"
+#include <stdlib.h>
+
+/* Declarations */
+#define ARENA_BLOCK_SIZE 4096 /* the smallest block which is allocated */
+#define ARENA_ALIGNMENT 16    /* every allocation starts at a multiple of this number of bytes */
+
+/* size rounded up to a multiple of the alignment */
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+/* Prototypes */
+void arena_init(arena *a);
+void *arena_alloc(arena *a, long size);
+void arena_reset(arena *a);
+void arena_free(arena *a);
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file assembler.c
+ * @brief the library interface of the assembler: assembles a source code which is given in memory, and returns
+ * the content of the output files and the errors in memory, without any file I/O.
+ * all the state of an assembly is kept in an assembler context, so several sources can be assembled
+ * in the same process, one after another (reusing the memory of the context) or at the same time (a context for each).
+ */
+
+#include "assembler.h"
+#include "arena.h"
+#include "extern_refs.h"
+#include "fixup_list.h"
+#include "instruction_list.h"
+#include "lexer.h"
+#include "memory_image.h"
+#include "pre_processor.h"
+#include "stage_1.h"
+#include "stage_2.h"
+#include "string_pool.h"
+#include "symbols_table.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Prototypes */
+static void result_init(assembly_result *result);
+
+/**
+ * @brief initialize a new assembler context
+ *
+ * @param ctx the context to initialize
+ */
+void assembler_init(assembler_ctx *ctx) {
+    pool_init(&ctx->names);
+    arena_init(&ctx->temps);
+    macros_init(&ctx->macros, &ctx->names);
+    ctx->reading_macro = FALSE;
+    ctx->curr_macro = NULL;
+    ctx->expanded_source = NULL;
+
+    lines_init(&ctx->lines);
+    tokens_init(&ctx->tokens);
+    symbols_init(&ctx->symbols_tbl, &ctx->names);
+    instructions_init(&ctx->instructions);
+    fixups_init(&ctx->fixups);
+    ctx->num_threads = 1;
+    ctx->load_base = IC_INIT_ADDR;
+    ctx->memory_size = MEMORY_SIZE;
+    image_init(&ctx->data_memory);
+    image_init(&ctx->instr_memory);
+    ctx->unchecked_label = FALSE;
+    extern_refs_init(&ctx->externs);
+    ctx->entry_exists = ctx->extern_exists = FALSE;
+    ctx->ic = ctx->dc = 0;
+
+    ctx->error_occured_flag = FALSE;
+    ctx->curr_error = ERR_NO_ERROR;
+    ctx->curr_line = ctx->curr_token = NULL;
+    ctx->diagnostics.count = ctx->diagnostics.dropped = 0;
+
+    ctx->log = NULL;
+}
+
+/**
+ * @brief free the memory which was allocated to an assembler context
+ *
+ * @param ctx the context to free
+ */
+void assembler_free(assembler_ctx *ctx) {
+    freelist(&ctx->macros);
+    lines_free(&ctx->lines);
+    tokens_free(&ctx->tokens);
+    symbols_free(&ctx->symbols_tbl);
+    instructions_free(&ctx->instructions);
+    fixups_free(&ctx->fixups);
+    extern_refs_free(&ctx->externs);
+    pool_free(&ctx->names);
+    arena_free(&ctx->temps);
+    image_free(&ctx->data_memory);
+    image_free(&ctx->instr_memory);
+}
+
+/**
+ * @brief assembles a single source code: expands its macros, compiles it (stage 1) and resolves the labels (stage 2).
+ * the result must be freed with assembly_result_free, also when the assembly failed.
+ *
+ * @param ctx an initialized assembler context, which isn't used by another assembly at the same time
+ * @param src the source code (the content of a .as file)
+ * @param len length of the source code
+ * @param out the result of the assembly: the content of the output files, the errors and the messages
+ * @return SUCCESS if the source was assembled without errors, otherwise FAILED.
+ */
+status assemble_buffer(assembler_ctx *ctx, const char *src, size_t len, assembly_result *out) {
+    assembly_begin(ctx, out);
+
+    /* Pre-processor: expanding macros */
+    pre_processor(ctx, src, (long)len, &out->expanded);
+
+    /* Stage 1: Compiler  */
+    stage_1(ctx, &out->expanded);
+
+    /* Stage 2: Wrapper */
+    if (!ctx->error_occured_flag)
+        stage_2(ctx, out);
+
+    return assembly_end(ctx, out);
+}
+
+/**
+ * @brief prepares the context for assembling a new source: clears the state of the previous source,
+ * and initializes an empty result. used by assemble_buffer, or by a caller which runs the stages by itself.
+ *
+ * @param ctx the assembler context
+ * @param out the result of the assembly to initialize
+ */
+void assembly_begin(assembler_ctx *ctx, assembly_result *out) {
+    result_init(out);
+
+    ctx->log = &out->log;
+    ctx->entry_exists = FALSE;
+    ctx->extern_exists = FALSE;
+    ctx->error_occured_flag = FALSE;
+    ctx->externs.count = 0;
+    begin_line(ctx, NULL);
+    pool_reset(&ctx->names);
+    symbols_reset(&ctx->symbols_tbl);
+    ctx->instructions.count = 0;
+    ctx->fixups.count = 0;
+}
+
+/**
+ * @brief completes the result of an assembly: keeps the errors of the source in the result, and prints them all at once.
+ * the temporaries of the stages are released.
+ *
+ * @param ctx the assembler context
+ * @param out the result of the assembly
+ * @return SUCCESS if the source was assembled without errors, otherwise FAILED.
+ */
+status assembly_end(assembler_ctx *ctx, assembly_result *out) {
+    int num_diagnostics = ctx->diagnostics.count;
+
+    if (num_diagnostics > 0) {
+        out->diagnostics = (diagnostic *)malloc_w_check(sizeof(diagnostic) * num_diagnostics);
+        memcpy(out->diagnostics, ctx->diagnostics.items, sizeof(diagnostic) * num_diagnostics);
+        out->num_diagnostics = num_diagnostics;
+    }
+    flush_diagnostics(ctx);
+    arena_reset(&ctx->temps);
+
+    ctx->log = NULL;
+    return out->has_output ? SUCCESS : FAILED;
+}
+
+/**
+ * @brief initialize an empty result of an assembly
+ *
+ * @param result the result to initialize
+ */
+static void result_init(assembly_result *result) {
+    text_buffer_init(&result->expanded);
+    text_buffer_init(&result->object);
+    text_buffer_init(&result->entries);
+    text_buffer_init(&result->externals);
+    text_buffer_init(&result->log);
+    result->has_output = FALSE;
+    result->has_entries = FALSE;
+    result->has_externals = FALSE;
+    result->diagnostics = NULL;
+    result->num_diagnostics = 0;
+}
+
+/**
+ * @brief free the memory which was allocated to the result of an assembly
+ *
+ * @param result the result to free
+ */
+void assembly_result_free(assembly_result *result) {
+    text_buffer_free(&result->expanded);
+    text_buffer_free(&result->object);
+    text_buffer_free(&result->entries);
+    text_buffer_free(&result->externals);
+    text_buffer_free(&result->log);
+    free(result->diagnostics);
+    result->diagnostics = NULL;
+    result->num_diagnostics = 0;
+}
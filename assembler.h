@@ -0,0 +1,15 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "global.h"
+#include <stddef.h>
+
+/* Prototypes */
+void assembler_init(assembler_ctx *ctx);
+void assembler_free(assembler_ctx *ctx);
+status assemble_buffer(assembler_ctx *ctx, const char *src, size_t len, assembly_result *out);
+void assembly_begin(assembler_ctx *ctx, assembly_result *out);
+status assembly_end(assembler_ctx *ctx, assembly_result *out);
+void assembly_result_free(assembly_result *result);
+
+#endif
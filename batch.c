@@ -0,0 +1,324 @@
+/**
+ * @file batch.c
+ * @brief this file includes all the functions which are assembling the files of the command line.
+ * the files can be assembled by a pool of workers (threads), each with its own assembler context.
+ * the largest files are assembled first, so a huge file doesn't leave the other workers idle at the end,
+ * when there are more workers than files, the first pass of each file is split over the spare workers,
+ * and the console output of each file is collected and printed in the order of the command line.
+ * with a build cache, a file which was assembled before (with the same content and options) is read from the cache,
+ * and with an assembler server, the files are sent to the server instead of being assembled by the workers.
+ */
+
+#include "batch.h"
+#include "arena.h"
+#include "assembler.h"
+#include "build_cache.h"
+#include "server.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Prototypes */
+static void process_file(assembler_ctx *ctx, file_job *job, batch_options *options);
+static void assemble_source(assembler_ctx *ctx, batch_options *options, source_file *source, assembly_result *result);
+static void write_output_file(assembler_ctx *ctx, file_job *job, int type, text_buffer *content);
+static void print_output(text_buffer *output, char *text);
+static void *worker(void *arg);
+static long source_size(arena *temps, char *filename);
+static int compare_jobs(const void *a, const void *b);
+
+/**
+ * @brief assembles all the given files, and prints their console output in the given order.
+ *
+ * @param filenames the filenames w/o their extensions
+ * @param num_files number of files
+ * @param num_workers number of threads: the number of files to assemble at the same time, and the spare threads
+ * (when there are less files) compile the first pass of the files in parallel
+ * @param options the options of the command line, which apply to all the files
+ */
+void run_batch(char **filenames, int num_files, int num_workers, batch_options *options) {
+    batch jobs_batch;
+    file_job *job;
+    pthread_t *threads;
+    assembler_ctx *ctx;
+    arena names; /* the names of the source files, which are measured before the contexts of the workers exist */
+    int i;
+
+    jobs_batch.jobs = (file_job *)malloc_w_check(sizeof(file_job) * num_files);
+    jobs_batch.queue = (file_job **)malloc_w_check(sizeof(file_job *) * num_files);
+    jobs_batch.num_jobs = num_files;
+    jobs_batch.next = 0;
+    jobs_batch.options = options;
+    for (i = 0; i < num_files; i++) {
+        job = &jobs_batch.jobs[i];
+        job->filename = filenames[i];
+        job->file_count = i + 1;
+        job->size = 0;
+        job->done = FALSE;
+        text_buffer_init(&job->output);
+        jobs_batch.queue[i] = job;
+    }
+
+    /* the workers which don't have a file of their own split the first pass of the files */
+    jobs_batch.threads_per_file = num_workers > num_files ? num_workers / num_files : 1;
+    if (num_workers > num_files)
+        num_workers = num_files;
+
+    if (num_workers <= 1) {
+        /* a single context is reused by all the files, and each file is printed when it's done */
+        ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+        assembler_init(ctx);
+        ctx->num_threads = jobs_batch.threads_per_file;
+        ctx->load_base = options->load_base;
+        ctx->memory_size = options->memory_size;
+        for (i = 0; i < num_files; i++) {
+            job = &jobs_batch.jobs[i];
+            process_file(ctx, job, options);
+            fwrite(job->output.data, 1, job->output.length, stdout);
+            text_buffer_free(&job->output);
+        }
+        assembler_free(ctx);
+        free(ctx);
+    } else {
+        /* the largest files first */
+        arena_init(&names);
+        for (i = 0; i < num_files; i++)
+            jobs_batch.jobs[i].size = source_size(&names, filenames[i]);
+        arena_free(&names);
+        qsort(jobs_batch.queue, num_files, sizeof(file_job *), compare_jobs);
+
+        pthread_mutex_init(&jobs_batch.lock, NULL);
+        pthread_cond_init(&jobs_batch.job_done, NULL);
+        threads = (pthread_t *)malloc_w_check(sizeof(pthread_t) * num_workers);
+        for (i = 0; i < num_workers; i++) {
+            if (pthread_create(&threads[i], NULL, worker, &jobs_batch) != 0) {
+                printf("Error: Fatal: Failed to start a worker.");
+                exit(1);
+            }
+        }
+
+        /* print the output of the files by their order, as soon as each one is done */
+        for (i = 0; i < num_files; i++) {
+            job = &jobs_batch.jobs[i];
+            pthread_mutex_lock(&jobs_batch.lock);
+            while (!job->done)
+                pthread_cond_wait(&jobs_batch.job_done, &jobs_batch.lock);
+            pthread_mutex_unlock(&jobs_batch.lock);
+
+            fwrite(job->output.data, 1, job->output.length, stdout);
+            text_buffer_free(&job->output);
+        }
+
+        for (i = 0; i < num_workers; i++)
+            pthread_join(threads[i], NULL);
+        free(threads);
+        pthread_cond_destroy(&jobs_batch.job_done);
+        pthread_mutex_destroy(&jobs_batch.lock);
+    }
+
+    free(jobs_batch.jobs);
+    free(jobs_batch.queue);
+}
+
+/**
+ * @brief checks the load base and the memory size which the files are assembled with: the program must start in the
+ * memory, and the memory must not be larger than the addresses which an object file can hold (2 digits of base 32).
+ *
+ * @param load_base the address of the first instruction
+ * @param memory_size the number of addresses which the program must fit in
+ * @return true if the files can be assembled with these options, otherwise false.
+ */
+bool valid_memory_options(unsigned int load_base, int memory_size) {
+    return memory_size > 0 && memory_size <= MAX_MEMORY_SIZE && load_base < (unsigned int)memory_size;
+}
+
+/**
+ * @brief a worker of the pool: assembles the next file in the queue until the queue is empty.
+ *
+ * @param arg the batch
+ * @return NULL
+ */
+static void *worker(void *arg) {
+    batch *jobs_batch = (batch *)arg;
+    assembler_ctx *ctx;
+    file_job *job;
+
+    ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+    assembler_init(ctx);
+    ctx->num_threads = jobs_batch->threads_per_file;
+    ctx->load_base = jobs_batch->options->load_base;
+    ctx->memory_size = jobs_batch->options->memory_size;
+
+    for (;;) {
+        pthread_mutex_lock(&jobs_batch->lock);
+        job = jobs_batch->next < jobs_batch->num_jobs ? jobs_batch->queue[jobs_batch->next++] : NULL;
+        pthread_mutex_unlock(&jobs_batch->lock);
+        if (job == NULL)
+            break;
+
+        process_file(ctx, job, jobs_batch->options);
+
+        pthread_mutex_lock(&jobs_batch->lock);
+        job->done = TRUE;
+        pthread_cond_broadcast(&jobs_batch->job_done);
+        pthread_mutex_unlock(&jobs_batch->lock);
+    }
+
+    assembler_free(ctx);
+    free(ctx);
+    return NULL;
+}
+
+/**
+ * Processes a single assembly source file, and stores its console output in the job.
+ * the temporaries of the file (such as its filenames) are allocated from the arena of the context, which is
+ * reset when the file is done, so the same memory serves all the files of the worker.
+ * @param ctx the assembler context
+ * @param job the file to process
+ * @param options the options of the command line
+ */
+static void process_file(assembler_ctx *ctx, file_job *job, batch_options *options) {
+    char *input_filename;
+    char title[MAX_TITLE_LENGTH];
+    source_file source;     /* the content of the source file */
+    assembly_result result; /* the output of the assembly */
+    status read_status;
+    char key[CACHE_KEY_LENGTH + 1];
+    double start;
+
+    /* add filename extension, ".as" */
+    input_filename = generate_file_name(&ctx->temps, job->filename, FILE_INPUT);
+
+    /* title */
+    print_output(&job->output, "\n\n ___\n");
+    sprintf(title, "|#%2d| File: ", job->file_count);
+    print_output(&job->output, title);
+    print_output(&job->output, input_filename);
+    print_output(&job->output, "                \n");
+    print_output(&job->output, " ‾‾‾  ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾");
+
+    /* the whole source is in memory at once */
+    read_status = source_open(&source, input_filename);
+
+    if (!read_status) {
+        /* file couldn't be opened or read. */
+        print_output(&job->output, "Error: There is a problem with the file \"");
+        print_output(&job->output, job->filename);
+        print_output(&job->output, ".as\". skipping to the next one... \n");
+        print_output(&job->output, "The assembler failed on file: ");
+        print_output(&job->output, job->filename);
+        arena_reset(&ctx->temps);
+        return;
+    }
+
+    if (options->cache == NULL)
+        assemble_source(ctx, options, &source, &result);
+    else {
+        /* the result of a source which didn't change is the same as before */
+        cache_key(options->cache, source.data, source.length, key);
+        if (!cache_load(options->cache, &ctx->temps, key, source.data, source.length, &result)) {
+            start = wall_seconds();
+            assemble_source(ctx, options, &source, &result);
+            cache_store(options->cache, &ctx->temps, key, source.data, source.length, &result, wall_seconds() - start);
+        }
+    }
+    source_close(&source);
+
+    /* the messages of all the stages, incl. the errors of the file */
+    text_buffer_append(&job->output, result.log.data, result.log.length);
+
+    if (options->emit_am)
+        write_output_file(ctx, job, FILE_MACRO, &result.expanded);
+
+    /* output files are created only if there were no errors at the process */
+    if (result.has_output) {
+        write_output_file(ctx, job, FILE_OBJECT, &result.object);
+        if (result.has_entries)
+            write_output_file(ctx, job, FILE_ENTRY, &result.entries);
+        if (result.has_externals)
+            write_output_file(ctx, job, FILE_EXTERN, &result.externals);
+    }
+
+    print_output(&job->output, "\n\nClosing file '");
+    print_output(&job->output, job->filename);
+    print_output(&job->output, "'\n");
+    print_output(&job->output, "‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
+
+    assembly_result_free(&result);
+    arena_reset(&ctx->temps);
+}
+
+/**
+ * @brief assembles a source by the assembler server of the options, or by the context when there is no server.
+ * a server which can't be reached (or fails) doesn't fail the file, the source is assembled by the context.
+ *
+ * @param ctx the assembler context
+ * @param options the options of the command line
+ * @param source the content of the source
+ * @param result the result of the assembly
+ */
+static void assemble_source(assembler_ctx *ctx, batch_options *options, source_file *source, assembly_result *result) {
+    if (options->server != NULL && remote_assemble(options->server, source->data, source->length,
+                                                   options->load_base, options->memory_size, result))
+        return;
+    assemble_buffer(ctx, source->data, source->length, result);
+}
+
+/**
+ * @brief writes an output file at once
+ *
+ * @param ctx the assembler context, the name of the file is allocated from its arena
+ * @param job the file which is assembled, a failure is reported to its console output
+ * @param type the type of the file, such as FILE_OBJECT
+ * @param content the content of the file
+ */
+static void write_output_file(assembler_ctx *ctx, file_job *job, int type, text_buffer *content) {
+    char *filename_w_ext = generate_file_name(&ctx->temps, job->filename, type);
+    FILE *fd = fopen(filename_w_ext, "w");
+    if (fd == NULL) {
+        print_output(&job->output, "Failed creating file");
+        return;
+    }
+    fwrite(content->data, 1, content->length, fd);
+    fclose(fd);
+}
+
+/**
+ * @brief appends a message to the console output of a file
+ *
+ * @param output the console output
+ * @param text the message
+ */
+static void print_output(text_buffer *output, char *text) {
+    text_buffer_append(output, text, strlen(text));
+}
+
+/**
+ * @param temps the arena to allocate the name of the source file from
+ * @param filename the filename w/o its extension
+ * @return long the size of the source file, 0 if it can't be opened.
+ */
+static long source_size(arena *temps, char *filename) {
+    FILE *fd = fopen(generate_file_name(temps, filename, FILE_INPUT), "r");
+    long size = 0;
+
+    if (fd != NULL) {
+        if (fseek(fd, 0, SEEK_END) == 0)
+            size = ftell(fd);
+        fclose(fd);
+    }
+    return size;
+}
+
+/**
+ * @brief compares 2 files by their order of assembling: the largest first, and by the order of the command line.
+ */
+static int compare_jobs(const void *a, const void *b) {
+    const file_job *job_a = *(const file_job **)a;
+    const file_job *job_b = *(const file_job **)b;
+
+    if (job_a->size != job_b->size)
+        return job_a->size > job_b->size ? -1 : 1;
+    return job_a->file_count - job_b->file_count;
+}
@@ -0,0 +1,46 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "global.h"
+#include "build_cache.h"
+#include <pthread.h>
+
+/* Declarations */
+#define MAX_TITLE_LENGTH 64 /* Maximum length of a formatted line of a title, w/o the filename */
+#define MAX_JOBS 1024       /* Maximum number of files which are assembled at the same time */
+
+/* a source file of the batch, and its console output */
+typedef struct {
+    char *filename;     /* the filename w/o its extension */
+    int file_count;     /* the number of the file in order */
+    long size;          /* size of the source file, the largest files are assembled first */
+    bool done;          /* true when the file was assembled and its output is complete */
+    text_buffer output; /* the console output of the file */
+} file_job;
+
+/* the options of the command line, which apply to all the files */
+typedef struct {
+    bool emit_am;           /* true to write the source after expanding macros to a .am file */
+    unsigned int load_base; /* the address of the first instruction of each file */
+    int memory_size;        /* the number of addresses which each file must fit in (upto MAX_MEMORY_SIZE) */
+    build_cache *cache;     /* the build cache of the files, NULL when there is no cache */
+    char *server;           /* the socket of an assembler server which assembles the files, NULL to assemble here */
+} batch_options;
+
+/* a batch of files which is assembled by a pool of workers */
+typedef struct {
+    file_job *jobs;          /* the files in the order of the command line */
+    file_job **queue;        /* the files in the order of assembling them */
+    int num_jobs;            /* number of files */
+    int next;                /* index of the next file in the queue */
+    batch_options *options;  /* the options of the command line */
+    int threads_per_file;    /* number of threads which compile the first pass of each file */
+    pthread_mutex_t lock;    /* protects next and done */
+    pthread_cond_t job_done; /* signaled when a file is done */
+} batch;
+
+/* Prototypes */
+void run_batch(char **filenames, int num_files, int num_workers, batch_options *options);
+bool valid_memory_options(unsigned int load_base, int memory_size);
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file bench_driver.c
+ * @brief benchmark driver: assembles a source with the assembler library, and reports the time, the throughput
+ * (source lines per second) and the peak RSS of the process after each stage: pre_processor, stage_1, stage_2
+ * (encoding the instructions with the addresses of the labels) and output (building the content of the output files).
+ * before the stages, it reports the time of splitting the source to lines by each scanning kernel which the
+ * processor supports.
+ *
+ * usage: bench_driver [-r repeat] [-t threads] file.as
+ *        bench_driver -header
+ * with -t, a large source is compiled by stage_1 over chunks, and encoded by stage_2 over slices, with the given
+ * number of threads.
+ * the stages are repeated and the fastest run is reported, by the wall time (so the threads of a stage aren't added
+ * up). the driver handles a single file, so the peak RSS of the process is the peak of that file.
+ * the generated programs are larger than the memory, so they are compiled without a memory size, but the object of
+ * a program which doesn't fit can't be written (its addresses have 2 digits of base 32), so the output stage is
+ * measured only for programs which fit in the memory.
+ */
+
+#define _POSIX_C_SOURCE 199309L /* clock_gettime */
+
+#include "../assembler.h"
+#include "../pre_processor.h"
+#include "../scanner.h"
+#include "../stage_1.h"
+#include "../stage_2.h"
+#include "../utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/* Declarations */
+#define BENCH_SUMMARY "; bench source: lines=%ld words=%ld" /* the last line of a generated source */
+#define MAX_SUMMARY_LENGTH 80
+#define DEFAULT_REPEAT 3
+#define NUM_STAGES 4
+#define OUTPUT_STAGE 3 /* index of the output stage, which is skipped for programs which don't fit in the memory */
+
+static const char *stage_names[NUM_STAGES] = {"pre_processor", "stage_1", "stage_2", "output"};
+
+/* Prototypes */
+static void read_summary(source_file *source, long *lines, long *words);
+static long peak_rss();
+static double wall_time();
+
+int main(int argc, char *argv[]) {
+    char *filename;
+    source_file source;
+    assembler_ctx *ctx;
+    assembly_result result;
+    double best[NUM_STAGES];
+    long rss[NUM_STAGES];
+    double times[NUM_STAGES + 1];
+    long lines, words;
+    int repeat = DEFAULT_REPEAT, num_threads = 1;
+    int i, run, kernel, default_kernel, num_measured;
+    char split_name[MAX_SUMMARY_LENGTH];
+
+    if (argc == 2 && !strcmp(argv[1], "-header")) {
+        printf("%-28s %9s %9s  %-14s %10s %12s %14s\n", "file", "lines", "words", "stage", "ms", "lines/s", "peak RSS (KB)");
+        return 0;
+    }
+    for (i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-r") && atoi(argv[i + 1]) > 0)
+            repeat = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-t") && atoi(argv[i + 1]) > 0)
+            num_threads = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i != argc - 1) {
+        fprintf(stderr, "usage: %s [-r repeat] [-t threads] file.as\n", argv[0]);
+        return 1;
+    }
+    filename = argv[i];
+
+    if (!source_open(&source, filename)) {
+        fprintf(stderr, "Failed to open %s\n", filename);
+        return 1;
+    }
+    read_summary(&source, &lines, &words);
+
+    ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+    assembler_init(ctx);
+    ctx->num_threads = num_threads;
+    ctx->memory_size = 0; /* the generated programs are larger than the memory, the stages are measured anyway */
+
+    /* the same split of the source by each kernel, the stages use the default (fastest) kernel */
+    default_kernel = ctx->lines.kernel;
+    for (kernel = SCAN_SCALAR; kernel <= SCAN_AVX2; kernel++) {
+        if (!set_scan_kernel(&ctx->lines, kernel))
+            continue;
+        for (run = 0; run < repeat; run++) {
+            times[0] = wall_time();
+            split_lines(&ctx->lines, source.data, source.length);
+            times[1] = wall_time();
+            if (run == 0 || times[1] - times[0] < best[0])
+                best[0] = times[1] - times[0];
+        }
+        sprintf(split_name, "split (%s)", scan_kernel_name(kernel));
+        printf("%-28s %9ld %9ld  %-14s %10.2f %12.0f %14ld\n", filename, lines, words, split_name,
+               best[0] * 1000, best[0] > 0 ? lines / best[0] : 0, peak_rss());
+    }
+    set_scan_kernel(&ctx->lines, default_kernel);
+
+    num_measured = NUM_STAGES;
+    for (run = 0; run < repeat; run++) {
+        assembly_begin(ctx, &result);
+
+        times[0] = wall_time();
+        pre_processor(ctx, source.data, source.length, &result.expanded);
+        times[1] = wall_time();
+        rss[0] = peak_rss();
+
+        stage_1(ctx, &result.expanded);
+        times[2] = wall_time();
+        rss[1] = peak_rss();
+        if (ctx->error_occured_flag) {
+            fprintf(stderr, "%s: the source has errors\n", filename);
+            return 1;
+        }
+
+        resolve_labels(ctx);
+        times[3] = wall_time();
+        rss[2] = peak_rss();
+
+        if (ctx->load_base + ctx->ic + ctx->dc <= MEMORY_SIZE)
+            generate_output(ctx, &result);
+        else
+            num_measured = OUTPUT_STAGE;
+        times[4] = wall_time();
+        rss[3] = peak_rss();
+
+        assembly_end(ctx, &result);
+        assembly_result_free(&result);
+
+        for (i = 0; i < NUM_STAGES; i++) {
+            if (run == 0 || times[i + 1] - times[i] < best[i])
+                best[i] = times[i + 1] - times[i];
+        }
+    }
+
+    for (i = 0; i < num_measured; i++)
+        printf("%-28s %9ld %9ld  %-14s %10.2f %12.0f %14ld\n", filename, lines, words, stage_names[i],
+               best[i] * 1000, best[i] > 0 ? lines / best[i] : 0, rss[i]);
+    if (num_measured < NUM_STAGES)
+        printf("%-28s %9ld %9ld  %-14s %10s %12s %14s\n", filename, lines, words, stage_names[OUTPUT_STAGE], "-", "-",
+               "-");
+
+    assembler_free(ctx);
+    free(ctx);
+    source_close(&source);
+    return 0;
+}
+
+/**
+ * @brief reads the number of lines and memory words of a generated source from its last line.
+ * a source which wasn't generated is measured by its number of lines.
+ */
+static void read_summary(source_file *source, long *lines, long *words) {
+    char summary[MAX_SUMMARY_LENGTH];
+    char *last_line;
+    long i, length;
+
+    *lines = *words = 0;
+    for (i = 0; i < source->length; i++) {
+        if (source->data[i] == '\n')
+            (*lines)++;
+    }
+
+    for (last_line = source->data + source->length - 1; last_line > source->data && last_line[-1] != '\n'; last_line--)
+        ;
+    if (last_line > source->data && last_line[-1] == '\n' && last_line == source->data + source->length - 1) {
+        /* the source ends with a new line, the last line starts before it */
+        for (last_line--; last_line > source->data && last_line[-1] != '\n'; last_line--)
+            ;
+    }
+
+    /* the source isn't null terminated when it's mapped, so the summary is copied before it's parsed */
+    length = source->data + source->length - last_line;
+    if (length > MAX_SUMMARY_LENGTH - 1)
+        length = MAX_SUMMARY_LENGTH - 1;
+    memcpy(summary, last_line, length);
+    summary[length] = '\0';
+    sscanf(summary, BENCH_SUMMARY, lines, words);
+}
+
+/**
+ * @return long the peak resident set size of the process (KB)
+ */
+static long peak_rss() {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @return double the time of a monotonic clock, in seconds
+ */
+static double wall_time() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
@@ -0,0 +1,398 @@
+/**
+ * @file gen_source.c
+ * @brief generator of valid assembly sources of adjustable size and shape, for the benchmark.
+ * the source is made of .extern declarations, macro definitions, a body of instruction and data lines
+ * (some of them with labels, some of them macro calls), and .entry declarations at the end.
+ * the last line is a comment with the number of lines and the number of memory words of the program.
+ *
+ * usage: gen_source [options] > file.as
+ *   -n lines     number of lines (default 1000)
+ *   -l percent   lines of the body which define a label (default 20)
+ *   -m count     number of macros (default 4)
+ *   -b lines     number of lines in the body of each macro (default 4)
+ *   -c percent   instruction lines which call a macro (default 5)
+ *   -x percent   label operands which refer to an external label (default 10)
+ *   -e percent   labels which are declared as entries (default 10)
+ *   -d percent   lines of the body which are .data directives (default 10)
+ *   -s percent   lines of the body which are .string directives (default 5)
+ *   -t percent   lines of the body which are .struct directives (default 5)
+ *   -r seed      seed of the random generator (default 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define MAX_GEN_LINE 82        /* a generated line is always shorter than the line limit of the assembler */
+#define EXTERNS_PER_LINES 50   /* an external label is declared for every 50 lines */
+#define MAX_DATA_NUMBERS 6     /* maximum numbers in a .data directive */
+#define MAX_STRING_LENGTH 20   /* maximum length of a string in .string and .struct directives */
+#define MAX_IMMEDIATE 100      /* immediate numbers are between -MAX_IMMEDIATE and MAX_IMMEDIATE */
+
+/* kinds of the lines of the body */
+enum line_kinds { LINE_INSTRUCTION,
+                  LINE_MACRO_CALL,
+                  LINE_DATA,
+                  LINE_STRING,
+                  LINE_STRUCT };
+
+/* kinds of operands */
+enum operand_kinds { OPERAND_NONE,
+                     OPERAND_IMMEDIATE,
+                     OPERAND_DIRECT,
+                     OPERAND_STRUCT,
+                     OPERAND_REGISTER };
+
+/* a command and the kinds of operands it accepts (a bitmask of 1 << kind) */
+typedef struct {
+    char *name;
+    int src_kinds;
+    int dest_kinds;
+} command_shape;
+
+#define ANY_KIND ((1 << OPERAND_IMMEDIATE) | (1 << OPERAND_DIRECT) | (1 << OPERAND_STRUCT) | (1 << OPERAND_REGISTER))
+#define WRITABLE_KIND ((1 << OPERAND_DIRECT) | (1 << OPERAND_STRUCT) | (1 << OPERAND_REGISTER))
+#define LABEL_KIND ((1 << OPERAND_DIRECT) | (1 << OPERAND_STRUCT))
+#define NO_KIND (1 << OPERAND_NONE)
+
+static const command_shape shapes[] = {
+    {"mov", ANY_KIND, WRITABLE_KIND},
+    {"cmp", ANY_KIND, ANY_KIND},
+    {"add", ANY_KIND, WRITABLE_KIND},
+    {"sub", ANY_KIND, WRITABLE_KIND},
+    {"not", NO_KIND, WRITABLE_KIND},
+    {"clr", NO_KIND, WRITABLE_KIND},
+    {"lea", LABEL_KIND, WRITABLE_KIND},
+    {"inc", NO_KIND, WRITABLE_KIND},
+    {"dec", NO_KIND, WRITABLE_KIND},
+    {"jmp", NO_KIND, WRITABLE_KIND},
+    {"bne", NO_KIND, WRITABLE_KIND},
+    {"get", NO_KIND, WRITABLE_KIND},
+    {"prn", NO_KIND, ANY_KIND},
+    {"jsr", NO_KIND, WRITABLE_KIND},
+    {"rts", NO_KIND, NO_KIND},
+    {"hlt", NO_KIND, NO_KIND}};
+
+#define NUM_SHAPES (sizeof(shapes) / sizeof(shapes[0]))
+
+/* the shape of the source to generate */
+typedef struct {
+    long lines;
+    int label_percent;
+    int macros;
+    int macro_lines;
+    int call_percent;
+    int extern_percent;
+    int entry_percent;
+    int data_percent;
+    int string_percent;
+    int struct_percent;
+    unsigned long seed;
+} source_shape;
+
+/* the state of the generator */
+typedef struct {
+    source_shape shape;
+    unsigned long random;   /* state of the random generator */
+    long num_code_labels;   /* labels of instruction lines are named L<n> */
+    long num_data_labels;   /* labels of .data and .string lines are named D<n> */
+    long num_struct_labels; /* labels of .struct lines are named S<n> */
+    long num_externs;       /* external labels are named X<n> */
+    long words;             /* number of memory words of the program */
+} generator;
+
+/* Prototypes */
+static void parse_args(int argc, char *argv[], source_shape *shape);
+static void generate(generator *gen, FILE *out);
+static int next_random(generator *gen, int range);
+static long write_instruction(generator *gen, char *line);
+static long write_operand(generator *gen, char *line, int kinds, int *kind);
+static long write_data_line(generator *gen, char *line, int kind);
+
+int main(int argc, char *argv[]) {
+    generator gen;
+
+    parse_args(argc, argv, &gen.shape);
+    gen.random = gen.shape.seed;
+    generate(&gen, stdout);
+    return 0;
+}
+
+/**
+ * @brief reads the options of the command line to the shape of the source
+ */
+static void parse_args(int argc, char *argv[], source_shape *shape) {
+    int i;
+    long value;
+
+    shape->lines = 1000;
+    shape->label_percent = 20;
+    shape->macros = 4;
+    shape->macro_lines = 4;
+    shape->call_percent = 5;
+    shape->extern_percent = 10;
+    shape->entry_percent = 10;
+    shape->data_percent = 10;
+    shape->string_percent = 5;
+    shape->struct_percent = 5;
+    shape->seed = 1;
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        value = atol(argv[i + 1]);
+        if (argv[i][0] != '-' || argv[i][2] != '\0' || value < 0) {
+            fprintf(stderr, "Invalid option: %s %s\n", argv[i], argv[i + 1]);
+            exit(1);
+        }
+        switch (argv[i][1]) {
+        case 'n': shape->lines = value; break;
+        case 'l': shape->label_percent = (int)value; break;
+        case 'm': shape->macros = (int)value; break;
+        case 'b': shape->macro_lines = (int)value; break;
+        case 'c': shape->call_percent = (int)value; break;
+        case 'x': shape->extern_percent = (int)value; break;
+        case 'e': shape->entry_percent = (int)value; break;
+        case 'd': shape->data_percent = (int)value; break;
+        case 's': shape->string_percent = (int)value; break;
+        case 't': shape->struct_percent = (int)value; break;
+        case 'r': shape->seed = (unsigned long)value; break;
+        default:
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            exit(1);
+        }
+    }
+    if (i < argc) {
+        fprintf(stderr, "Missing value of option: %s\n", argv[i]);
+        exit(1);
+    }
+    if (shape->data_percent + shape->string_percent + shape->struct_percent > 100) {
+        fprintf(stderr, "The data directives can't be more than 100%% of the lines\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief a linear congruential generator, so a seed generates the same source on every platform
+ *
+ * @param range the range of the random number
+ * @return int a random number between 0 and range - 1
+ */
+static int next_random(generator *gen, int range) {
+    gen->random = (gen->random * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+    return (int)((gen->random >> 8) % range);
+}
+
+/**
+ * @brief generates the source. the kinds of the lines of the body are chosen first, so the number of labels
+ * of each kind is known before any label is referenced (labels are referenced before and after their definition).
+ */
+static void generate(generator *gen, FILE *out) {
+    source_shape *shape = &gen->shape;
+    char line[MAX_GEN_LINE];
+    char *kinds;
+    long *macro_words;
+    long header_lines, body_lines, entry_lines, entries_left;
+    long i, code_label = 0, data_label = 0, struct_label = 0;
+    int j, kind, percent;
+
+    gen->num_externs = shape->extern_percent > 0 ? 1 + shape->lines / EXTERNS_PER_LINES : 0;
+    header_lines = 1 + gen->num_externs + (long)shape->macros * (shape->macro_lines + 2);
+
+    /* the rest of the lines are the body, and the .entry lines of some of its labels */
+    body_lines = (shape->lines - header_lines) * 10000 / (10000 + (long)shape->label_percent * shape->entry_percent);
+    if (body_lines < 1)
+        body_lines = 1;
+
+    kinds = (char *)malloc(body_lines * 2);
+    macro_words = (long *)malloc(sizeof(long) * (shape->macros + 1));
+    if (kinds == NULL || macro_words == NULL) {
+        fprintf(stderr, "Memory allocation failed\n");
+        exit(1);
+    }
+
+    /* choose the kind of each line of the body, and whether it has a label */
+    gen->num_code_labels = gen->num_data_labels = gen->num_struct_labels = 0;
+    for (i = 0; i < body_lines; i++) {
+        percent = next_random(gen, 100);
+        if (percent < shape->data_percent)
+            kind = LINE_DATA;
+        else if ((percent -= shape->data_percent) < shape->string_percent)
+            kind = LINE_STRING;
+        else if ((percent -= shape->string_percent) < shape->struct_percent)
+            kind = LINE_STRUCT;
+        else if (shape->macros > 0 && next_random(gen, 100) < shape->call_percent)
+            kind = LINE_MACRO_CALL;
+        else
+            kind = LINE_INSTRUCTION;
+        kinds[i * 2] = (char)kind;
+
+        /* a macro call can't have a label (the label would be defined again in every call) */
+        kinds[i * 2 + 1] = kind != LINE_MACRO_CALL && next_random(gen, 100) < shape->label_percent;
+        if (kinds[i * 2 + 1]) {
+            if (kind == LINE_INSTRUCTION)
+                gen->num_code_labels++;
+            else if (kind == LINE_STRUCT)
+                gen->num_struct_labels++;
+            else
+                gen->num_data_labels++;
+        }
+    }
+    entry_lines = (gen->num_code_labels + gen->num_data_labels + gen->num_struct_labels) * shape->entry_percent / 100;
+
+    for (i = 0; i < gen->num_externs; i++)
+        fprintf(out, ".extern X%ld\n", i);
+
+    /* macro bodies hold instructions only, their words are counted for each call */
+    for (j = 0; j < shape->macros; j++) {
+        fprintf(out, "macro m%d\n", j);
+        macro_words[j] = 0;
+        for (i = 0; i < shape->macro_lines; i++) {
+            macro_words[j] += write_instruction(gen, line);
+            fprintf(out, "\t%s\n", line);
+        }
+        fprintf(out, "endmacro\n");
+    }
+    gen->words = 0;
+
+    for (i = 0; i < body_lines; i++) {
+        kind = kinds[i * 2];
+        if (kinds[i * 2 + 1]) {
+            if (kind == LINE_INSTRUCTION)
+                fprintf(out, "L%ld: ", code_label++);
+            else if (kind == LINE_STRUCT)
+                fprintf(out, "S%ld: ", struct_label++);
+            else
+                fprintf(out, "D%ld: ", data_label++);
+        }
+
+        if (kind == LINE_MACRO_CALL) {
+            j = next_random(gen, shape->macros);
+            fprintf(out, "m%d\n", j);
+            gen->words += macro_words[j];
+        } else if (kind == LINE_INSTRUCTION) {
+            gen->words += write_instruction(gen, line);
+            fprintf(out, "%s\n", line);
+        } else {
+            gen->words += write_data_line(gen, line, kind);
+            fprintf(out, "%s\n", line);
+        }
+    }
+
+    /* declare entries of code labels, then data labels, then struct labels */
+    entries_left = entry_lines;
+    for (i = 0; i < gen->num_code_labels && entries_left > 0; i += 1 + next_random(gen, 4), entries_left--)
+        fprintf(out, ".entry L%ld\n", i);
+    for (i = 0; i < gen->num_data_labels && entries_left > 0; i += 1 + next_random(gen, 4), entries_left--)
+        fprintf(out, ".entry D%ld\n", i);
+    for (i = 0; i < gen->num_struct_labels && entries_left > 0; i += 1 + next_random(gen, 4), entries_left--)
+        fprintf(out, ".entry S%ld\n", i);
+
+    /* the words of the program are known only at the end */
+    fprintf(out, "; bench source: lines=%ld words=%ld\n", header_lines + body_lines + entry_lines - entries_left, gen->words);
+
+    free(kinds);
+    free(macro_words);
+}
+
+/**
+ * @brief writes an instruction with random operands which are valid for its command
+ *
+ * @param line destination of the instruction
+ * @return long the number of memory words of the instruction
+ */
+static long write_instruction(generator *gen, char *line) {
+    const command_shape *cmd = &shapes[next_random(gen, NUM_SHAPES)];
+    long words = 1; /* the first word */
+    int src_kind = OPERAND_NONE, dest_kind = OPERAND_NONE;
+
+    line += sprintf(line, "%s", cmd->name);
+    if (cmd->src_kinds != NO_KIND) {
+        line += sprintf(line, " ");
+        words += write_operand(gen, line, cmd->src_kinds, &src_kind);
+        line += strlen(line);
+        line += sprintf(line, ",");
+    }
+    if (cmd->dest_kinds != NO_KIND) {
+        line += sprintf(line, " ");
+        words += write_operand(gen, line, cmd->dest_kinds, &dest_kind);
+    }
+
+    /* 2 registers share a single word */
+    if (src_kind == OPERAND_REGISTER && dest_kind == OPERAND_REGISTER)
+        words--;
+    return words;
+}
+
+/**
+ * @brief writes a random operand of the given kinds
+ *
+ * @param line destination of the operand
+ * @param kinds the allowed kinds of the operand (a bitmask)
+ * @param kind the kind of the operand which was written
+ * @return long the number of memory words of the operand
+ */
+static long write_operand(generator *gen, char *line, int kinds, int *kind) {
+    long num_labels = gen->num_code_labels + gen->num_data_labels;
+    long label;
+
+    do
+        *kind = OPERAND_IMMEDIATE + next_random(gen, OPERAND_REGISTER);
+    while (!(kinds & (1 << *kind)));
+
+    /* without labels of the required kind, a label operand becomes another kind */
+    if (*kind == OPERAND_STRUCT && gen->num_struct_labels == 0)
+        *kind = OPERAND_DIRECT;
+    if (*kind == OPERAND_DIRECT && num_labels == 0 && gen->num_externs == 0)
+        *kind = (kinds & (1 << OPERAND_REGISTER)) ? OPERAND_REGISTER : OPERAND_IMMEDIATE;
+
+    switch (*kind) {
+    case OPERAND_IMMEDIATE:
+        sprintf(line, "#%d", next_random(gen, MAX_IMMEDIATE * 2 + 1) - MAX_IMMEDIATE);
+        return 1;
+
+    case OPERAND_DIRECT:
+        if (gen->num_externs > 0 && (num_labels == 0 || next_random(gen, 100) < gen->shape.extern_percent))
+            sprintf(line, "X%d", next_random(gen, (int)gen->num_externs));
+        else if ((label = next_random(gen, (int)num_labels)) < gen->num_code_labels)
+            sprintf(line, "L%ld", label);
+        else
+            sprintf(line, "D%ld", label - gen->num_code_labels);
+        return 1;
+
+    case OPERAND_STRUCT:
+        sprintf(line, "S%d.%d", next_random(gen, (int)gen->num_struct_labels), 1 + next_random(gen, 2));
+        return 2;
+
+    default:
+        sprintf(line, "r%d", next_random(gen, 8));
+        return 1;
+    }
+}
+
+/**
+ * @brief writes a random .data, .string or .struct directive
+ *
+ * @param line destination of the directive
+ * @param kind the kind of the line
+ * @return long the number of memory words of the directive
+ */
+static long write_data_line(generator *gen, char *line, int kind) {
+    int i, count;
+
+    if (kind == LINE_DATA) {
+        count = 1 + next_random(gen, MAX_DATA_NUMBERS);
+        line += sprintf(line, ".data %d", next_random(gen, 1000) - 500);
+        for (i = 1; i < count; i++)
+            line += sprintf(line, ", %d", next_random(gen, 1000) - 500);
+        return count;
+    }
+
+    line += sprintf(line, kind == LINE_STRING ? ".string \"" : ".struct %d, \"", next_random(gen, 100));
+    count = 1 + next_random(gen, MAX_STRING_LENGTH);
+    for (i = 0; i < count; i++)
+        *line++ = (char)('a' + next_random(gen, 26));
+    strcpy(line, "\"");
+
+    /* the characters and the null terminator, and the number of a struct */
+    return count + 1 + (kind == LINE_STRUCT);
+}
@@ -0,0 +1,260 @@
+/**
+ * @file build_cache.c
+ * @brief this file includes the build cache of the executable, which skips assembling sources which didn't change.
+ * an entry of the cache is a single file in the cache directory, named by a key of the content of the source, the
+ * version of the cache format and the options which change the output (so a change in any of them is a miss).
+ * the entry holds the console messages and the content of the output files of the source, so a hit prints and
+ * writes exactly what assembling the source would, without running any of the stages. the entry also keeps the
+ * source, which is compared on a hit, so 2 sources which have the same key never share an entry.
+ * an entry is written to a temporary file and renamed to its key, so a reader never sees a partial entry,
+ * and several workers (or processes) can share the same directory.
+ */
+
+#include "build_cache.h"
+#include "arena.h"
+#include "utils.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Declarations */
+#define NUM_SECTIONS_IN_ENTRY 5 /* log, .am, .ob, .ent and .ext */
+#define ENTRY_HAS_OUTPUT 1
+#define ENTRY_HAS_ENTRIES 2
+#define ENTRY_HAS_EXTERNALS 4
+
+/* Prototypes */
+static char *entry_path(build_cache *cache, arena *temps, const char *key, char *suffix);
+static void entry_sections(assembly_result *result, text_buffer **sections);
+
+/**
+ * @brief initialize a cache in a given directory, the directory is created if it doesn't exist
+ *
+ * @param cache the cache to initialize
+ * @param dir the cache directory
+ * @param load_base the address of the first instruction of the sources
+ * @param memory_size the number of addresses which the sources must fit in
+ * @return SUCCESS if the directory can be used, otherwise FAILED.
+ */
+status cache_init(build_cache *cache, char *dir, unsigned int load_base, int memory_size) {
+    char options[MAX_CACHE_HEADER_LENGTH];
+    struct stat info;
+
+    cache->dir = dir;
+    cache->hits = cache->misses = 0;
+    cache->saved_seconds = 0;
+    cache->next_temp = 0;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    sprintf(options, "%d %u %d", CACHE_FORMAT_VERSION, load_base, memory_size);
+    cache->options = hash_string(options);
+
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+        return FAILED;
+    return stat(dir, &info) == 0 && S_ISDIR(info.st_mode) ? SUCCESS : FAILED;
+}
+
+/**
+ * @brief free the resources of a cache, the entries stay in the directory
+ *
+ * @param cache the cache to free
+ */
+void cache_free(build_cache *cache) {
+    pthread_mutex_destroy(&cache->lock);
+}
+
+/**
+ * @brief makes the key of a source: its length and 2 hashes of its content, which are seeded by the options of
+ * the cache. the hashes use different multipliers, so a collision of both is unlikely.
+ *
+ * @param cache the cache
+ * @param src the content of the source
+ * @param length the number of characters in the source
+ * @param key the key, of CACHE_KEY_LENGTH digits and a null terminator
+ */
+void cache_key(build_cache *cache, const char *src, long length, char *key) {
+    unsigned long first = cache->options;
+    unsigned long second = cache->options ^ 0x9E3779B9UL;
+    long i;
+
+    for (i = 0; i < length; i++) {
+        first = ((first ^ (unsigned char)src[i]) * 16777619UL) & 0xFFFFFFFFUL;
+        second = ((second ^ (unsigned char)src[i]) * 0x5BD1E995UL) & 0xFFFFFFFFUL;
+        second ^= second >> 15;
+    }
+    sprintf(key, "%08lx%08lx%08lx", (unsigned long)length & 0xFFFFFFFFUL, first, second);
+}
+
+/**
+ * @brief reads the entry of a key, into the result of an assembly (the diagnostics aren't kept in the cache).
+ * a hit is counted with the time which it saved.
+ *
+ * @param cache the cache
+ * @param temps the arena of the temporaries (such as the path of the entry)
+ * @param key the key of the source
+ * @param src the content of the source, which must be the source of the entry
+ * @param length the number of characters in the source
+ * @param result the result to fill, must be freed with assembly_result_free if the entry was found
+ * @return true if the key has a complete entry of the same source, otherwise false.
+ */
+bool cache_load(build_cache *cache, arena *temps, const char *key, const char *src, long length,
+                assembly_result *result) {
+    double start = wall_seconds();
+    char header[MAX_CACHE_HEADER_LENGTH];
+    char magic[MAX_CACHE_HEADER_LENGTH];
+    text_buffer *sections[NUM_SECTIONS_IN_ENTRY];
+    long lengths[NUM_SECTIONS_IN_ENTRY];
+    long header_length, source_length, total, offset;
+    double seconds;
+    source_file entry;
+    int flags, i;
+
+    if (!source_open(&entry, entry_path(cache, temps, key, "")))
+        return FALSE;
+
+    /* the entry is mapped, so its header is copied before it's parsed */
+    for (header_length = 0; header_length < entry.length && header_length < MAX_CACHE_HEADER_LENGTH - 1 &&
+                            entry.data[header_length] != '\n';
+         header_length++)
+        ;
+    memcpy(header, entry.data, header_length);
+    header[header_length] = '\0';
+    if (sscanf(header, "%s %lf %d %ld %ld %ld %ld %ld %ld", magic, &seconds, &flags, &source_length, &lengths[0],
+               &lengths[1], &lengths[2], &lengths[3], &lengths[4]) != 4 + NUM_SECTIONS_IN_ENTRY ||
+        strcmp(magic, CACHE_MAGIC)) {
+        source_close(&entry);
+        return FALSE;
+    }
+    for (i = 0, total = header_length + 1 + source_length; i < NUM_SECTIONS_IN_ENTRY && lengths[i] >= 0; i++)
+        total += lengths[i];
+    if (i < NUM_SECTIONS_IN_ENTRY || total != entry.length) {
+        /* not an entry of this format */
+        source_close(&entry);
+        return FALSE;
+    }
+    if (source_length != length || memcmp(entry.data + header_length + 1, src, length)) {
+        /* another source with the same key */
+        source_close(&entry);
+        return FALSE;
+    }
+
+    result->has_output = (flags & ENTRY_HAS_OUTPUT) != 0;
+    result->has_entries = (flags & ENTRY_HAS_ENTRIES) != 0;
+    result->has_externals = (flags & ENTRY_HAS_EXTERNALS) != 0;
+    result->diagnostics = NULL;
+    result->num_diagnostics = 0;
+    entry_sections(result, sections);
+    for (i = 0, offset = header_length + 1 + length; i < NUM_SECTIONS_IN_ENTRY; offset += lengths[i++]) {
+        text_buffer_init(sections[i]);
+        text_buffer_append(sections[i], entry.data + offset, lengths[i]);
+    }
+    source_close(&entry);
+
+    pthread_mutex_lock(&cache->lock);
+    cache->hits++;
+    cache->saved_seconds += seconds - (wall_seconds() - start);
+    pthread_mutex_unlock(&cache->lock);
+    return TRUE;
+}
+
+/**
+ * @brief writes the result of assembling a source to the entry of its key, and counts a miss.
+ * a failure to write the entry isn't an error, the source is assembled again next time.
+ *
+ * @param cache the cache
+ * @param temps the arena of the temporaries (such as the path of the entry)
+ * @param key the key of the source
+ * @param src the content of the source
+ * @param length the number of characters in the source
+ * @param result the result of assembling the source
+ * @param seconds the time of assembling the source
+ */
+void cache_store(build_cache *cache, arena *temps, const char *key, const char *src, long length,
+                 assembly_result *result, double seconds) {
+    text_buffer *sections[NUM_SECTIONS_IN_ENTRY];
+    char suffix[MAX_CACHE_HEADER_LENGTH];
+    char *temp_path;
+    bool written;
+    FILE *fd;
+    int i;
+
+    pthread_mutex_lock(&cache->lock);
+    cache->misses++;
+    sprintf(suffix, ".%ld.%ld.tmp", (long)getpid(), cache->next_temp++);
+    pthread_mutex_unlock(&cache->lock);
+
+    temp_path = entry_path(cache, temps, key, suffix);
+    fd = fopen(temp_path, "w");
+    if (fd == NULL)
+        return;
+
+    entry_sections(result, sections);
+    fprintf(fd, "%s %f %d", CACHE_MAGIC, seconds,
+            (result->has_output ? ENTRY_HAS_OUTPUT : 0) | (result->has_entries ? ENTRY_HAS_ENTRIES : 0) |
+                (result->has_externals ? ENTRY_HAS_EXTERNALS : 0));
+    fprintf(fd, " %ld", length);
+    for (i = 0; i < NUM_SECTIONS_IN_ENTRY; i++)
+        fprintf(fd, " %ld", sections[i]->length);
+    fputc('\n', fd);
+    fwrite(src, 1, length, fd);
+    for (i = 0; i < NUM_SECTIONS_IN_ENTRY; i++)
+        fwrite(sections[i]->data, 1, sections[i]->length, fd);
+    written = !ferror(fd);
+    written = fclose(fd) == 0 && written;
+
+    if (!written || rename(temp_path, entry_path(cache, temps, key, "")) != 0)
+        remove(temp_path);
+}
+
+/**
+ * @brief prints the number of hits and misses of a cache, and the time which the hits saved
+ *
+ * @param cache the cache
+ */
+void cache_print_stats(build_cache *cache) {
+    printf("\nCache: %d hits, %d misses, %.2f ms saved\n", cache->hits, cache->misses, cache->saved_seconds * 1000);
+}
+
+/**
+ * @return double the time of the day, in seconds (the processor time counts all the threads of the process)
+ */
+double wall_seconds() {
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1e6;
+}
+
+/**
+ * @brief makes the path of a file in the cache directory
+ *
+ * @param cache the cache
+ * @param temps the arena of the path
+ * @param key the key of the entry
+ * @param suffix added after the key, e.g. for a temporary file
+ * @return char* the path
+ */
+static char *entry_path(build_cache *cache, arena *temps, const char *key, char *suffix) {
+    char *path = (char *)arena_alloc(temps, strlen(cache->dir) + 1 + CACHE_KEY_LENGTH + strlen(suffix) + 1);
+
+    sprintf(path, "%s/%s%s", cache->dir, key, suffix);
+    return path;
+}
+
+/**
+ * @brief the sections of an entry, by their order in the entry
+ *
+ * @param result the result of an assembly
+ * @param sections the buffers of the result: the log, and the content of the .am, .ob, .ent and .ext files
+ */
+static void entry_sections(assembly_result *result, text_buffer **sections) {
+    sections[0] = &result->log;
+    sections[1] = &result->expanded;
+    sections[2] = &result->object;
+    sections[3] = &result->entries;
+    sections[4] = &result->externals;
+}
@@ -0,0 +1,38 @@
+#ifndef BUILD_CACHE_H
+#define BUILD_CACHE_H
+
+#include "global.h"
+#include <pthread.h>
+
+/* Declarations */
+/* the version of the output of the assembler and of the entries: it must be bumped by any change which changes the
+ * console output or the output files of a source (e.g. the encoding, the errors or their messages), or the format
+ * of the entries, so the entries of the previous versions are missed */
+#define CACHE_FORMAT_VERSION 2
+#define CACHE_KEY_LENGTH 24           /* hex digits of a key: the length of the source and 2 hashes of it */
+#define CACHE_MAGIC "assembler-cache" /* the first word of an entry */
+#define MAX_CACHE_HEADER_LENGTH 160   /* Maximum length of the first line of an entry */
+
+/* a directory of assembled sources, which are found by the content of the source and the options */
+typedef struct {
+    char *dir;             /* the directory of the entries, NULL when there is no cache */
+    unsigned long options; /* hash of the version of the assembler and the options which change the output */
+    int hits;              /* number of sources which were found in the cache */
+    int misses;            /* number of sources which were assembled (and stored) */
+    double saved_seconds;  /* the time of assembling the hits, less the time of reading them */
+    long next_temp;        /* the number of the next temporary file (entries are renamed to their key when done) */
+    pthread_mutex_t lock;  /* protects the statistics and next_temp */
+} build_cache;
+
+/* Prototypes */
+status cache_init(build_cache *cache, char *dir, unsigned int load_base, int memory_size);
+void cache_free(build_cache *cache);
+void cache_key(build_cache *cache, const char *src, long length, char *key);
+bool cache_load(build_cache *cache, arena *temps, const char *key, const char *src, long length,
+                assembly_result *result);
+void cache_store(build_cache *cache, arena *temps, const char *key, const char *src, long length,
+                 assembly_result *result, double seconds);
+void cache_print_stats(build_cache *cache);
+double wall_seconds();
+
+#endif
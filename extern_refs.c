@@ -0,0 +1,67 @@
+/**
+ * @file extern_refs.c
+ * @brief this file includes all the functions which are managing a list of references to external labels.
+ * each reference is a word of the instructions memory which holds the address of an external label, and the
+ * references are listed in the .ext file by order of their addresses. a reference holds the id of its label rather
+ * than its name, so the list is a single array of pairs which is reused by the context for every source.
+ */
+
+#include "extern_refs.h"
+
+/**
+ * @brief initialize an empty references list
+ *
+ * @param list the list to initialize
+ */
+void extern_refs_init(extern_ref_list *list) {
+    list->count = 0;
+    list->capacity = EXTERN_REFS_INIT_CAPACITY;
+    list->items = (extern_ref *)malloc_w_check(sizeof(extern_ref) * list->capacity);
+}
+
+/**
+ * @brief free memory allocation of a given references list
+ *
+ * @param list the list to free
+ */
+void extern_refs_free(extern_ref_list *list) {
+    free(list->items);
+    list->items = NULL;
+    list->count = list->capacity = 0;
+}
+
+/**
+ * @brief function which adds a reference to an external label to the end of the list
+ *
+ * @param list the list to insert to
+ * @param label_id the id of the external label in the symbols table
+ * @param address index of the word which holds the address of the label in the instructions memory
+ */
+void add_extern_ref(extern_ref_list *list, int label_id, unsigned int address) {
+    extern_ref *item;
+
+    if (list->count == list->capacity) {
+        list->capacity *= 2;
+        list->items = (extern_ref *)realloc_w_check(list->items, sizeof(extern_ref) * list->capacity);
+    }
+
+    item = &list->items[list->count++];
+    item->label_id = label_id;
+    item->address = address;
+}
+
+/**
+ * @brief function which appends all the references of a list to the end of another list
+ *
+ * @param list the list to append to
+ * @param other the list whose references are appended
+ */
+void append_extern_refs(extern_ref_list *list, extern_ref_list *other) {
+    if (list->count + other->count > list->capacity) {
+        while (list->count + other->count > list->capacity)
+            list->capacity *= 2;
+        list->items = (extern_ref *)realloc_w_check(list->items, sizeof(extern_ref) * list->capacity);
+    }
+    memcpy(list->items + list->count, other->items, sizeof(extern_ref) * other->count);
+    list->count += other->count;
+}
@@ -0,0 +1,18 @@
+#ifndef EXTERN_REFS_H
+#define EXTERN_REFS_H
+
+#include "global.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define EXTERN_REFS_INIT_CAPACITY 64 /* initial length of the references array */
+
+/* Prototypes */
+void extern_refs_init(extern_ref_list *list);
+void extern_refs_free(extern_ref_list *list);
+void add_extern_ref(extern_ref_list *list, int label_id, unsigned int address);
+void append_extern_refs(extern_ref_list *list, extern_ref_list *other);
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file fixup_list.c
+ * @brief this file includes all the functions which are managing the list of references to labels (fixups).
+ * a label of an .entry directive may be defined later in the code, so the directive is recorded here, and resolved
+ * in stage 2 when the symbols table is complete.
+ */
+
+#include "fixup_list.h"
+
+/**
+ * @brief initialize an empty fixups list
+ *
+ * @param list the list to initialize
+ */
+void fixups_init(fixup_list *list) {
+    list->count = 0;
+    list->capacity = FIXUPS_INIT_CAPACITY;
+    list->items = (fixup *)malloc_w_check(sizeof(fixup) * list->capacity);
+}
+
+/**
+ * @brief free memory allocation of a given fixups list
+ *
+ * @param list the list to free
+ */
+void fixups_free(fixup_list *list) {
+    free(list->items);
+    list->items = NULL;
+    list->count = list->capacity = 0;
+}
+
+/**
+ * @brief function which adds a reference to a label to the end of the list
+ *
+ * @param list the list to insert to
+ * @param label_id the id of the label in the symbols table
+ * @param line_num the line of the reference
+ */
+void add_fixup(fixup_list *list, int label_id, int line_num) {
+    fixup *item;
+
+    if (list->count == list->capacity) {
+        list->capacity *= 2;
+        list->items = (fixup *)realloc_w_check(list->items, sizeof(fixup) * list->capacity);
+    }
+
+    item = &list->items[list->count++];
+    item->label_id = label_id;
+    item->line_num = line_num;
+}
@@ -0,0 +1,16 @@
+#ifndef FIXUP_LIST_H
+#define FIXUP_LIST_H
+
+#include "global.h"
+#include "utils.h"
+#include <stdlib.h>
+
+/* Declarations */
+#define FIXUPS_INIT_CAPACITY 64 /* initial length of the fixups array */
+
+/* Prototypes */
+void fixups_init(fixup_list *list);
+void fixups_free(fixup_list *list);
+void add_fixup(fixup_list *list, int label_id, int line_num);
+
+#endif
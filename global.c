@@ -17,13 +17,39 @@
 const char *commands[NUM_COMMANDS] = {
     "mov", "cmp", "add", "sub", "not", "clr", "lea", "inc", "dec", "jmp", "bne",
     "get", "prn", "jsr", "rts", "hlt"};
+/* ordered by the opcodes (enum commands), a single operand is a destination operand */
+const command_descriptor command_set[NUM_COMMANDS] = {
+    {2, ANY_METHOD, WRITABLE_METHOD},    /* mov */
+    {2, ANY_METHOD, ANY_METHOD},         /* cmp */
+    {2, ANY_METHOD, WRITABLE_METHOD},    /* add */
+    {2, ANY_METHOD, WRITABLE_METHOD},    /* sub */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* not */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* clr */
+    {2, MEMORY_METHOD, WRITABLE_METHOD}, /* lea */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* inc */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* dec */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* jmp */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* bne */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* get */
+    {1, NO_OPERAND, ANY_METHOD},         /* prn */
+    {1, NO_OPERAND, WRITABLE_METHOD},    /* jsr */
+    {0, NO_OPERAND, NO_OPERAND},         /* rts */
+    {0, NO_OPERAND, NO_OPERAND}};        /* hlt */
+/* number of additional words of an operand, ordered by the addressing methods (enum addressing_types) */
+const int operand_words[ADDR_UNKNOWN + 1] = {
+    1, /* immediate: the number */
+    1, /* direct: the address of the label */
+    2, /* struct: the address of the label, and the field */
+    1, /* register: the number of the register */
+    0};/* no operand */
 const char *directives[NUM_DIRECTIVES] = {
     ".data", ".string", ".struct", ".entry", ".extern"};
 const char base32[BASE_NUMBER] = {
     '!', '@', '#', '$', '%', '^', '&', '*', '<', '>', 'a', 'b', 'c',
     'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
     'q', 'r', 's', 't', 'u', 'v'};
-const err errors[] = {
+/* ordered by the error codes (enum error_codes) */
+const err errors[NUM_ERRORS] = {
     {"NO_ERROR", ""},
     {"LABEL_FIRST_CHAR_IS_LETTER", "First character in label has to be letter (upper or lower case)."},
     {"LABEL_ONLY_ALPHANUMERIC", "Label characters can be only lower or Upper case letters, numbers."},
@@ -45,65 +71,141 @@ const err errors[] = {
     {"COMMAND_UNEXPECTED_CHAR", "invalid token"},
     {"COMMAND_LABEL_DOES_NOT_EXIST", "Label doesn't exist."},
     {"FAILED_OPEN_FILE", "failed to create and open new file."},
-    {"", ""},
+    {"COMMAND_INVALID_METHOD", "Invalid addressing method of operand."},
+    {"COMMAND_INVALID_NUMBER_OF_OPERANDS", "Invalid number of operands for this command."},
+    {"COMMAND_INVALID_OPERANDS_METHODS", "Addressing method of operand is not allowed for this command."},
+    {"COMMAND_TOO_MANY_OPERANDS", "Too many operands."},
+    {"DATA_EXPECTED_COMMA_AFTER_NUM", "Expected a comma after a number."},
+    {"ENTRY_CANT_BE_EXTERN", "Entry label can't be external."},
+    {"EXPECTED_COMMA_BETWEEN_OPERANDS", "Expected a comma between operands."},
+    {"LABEL_DOES_NOT_EXIST", "Label doesn't exist."},
+    {"STRUCT_EXPECTED_STRING", "String is missing in struct"},
+    {"STRUCT_INVALID_NUM", "Number is invalid in struct"},
+    {"STRUCT_TOO_MANY_OPERANDS", "Too many operands"},
+    {"MEMORY_OVERFLOW", "The program doesn't fit in the memory (too many instruction and data words)."},
     {"UNDEFINED", "Undefined error."}};
 
-char *curr_error_key = "NO_ERROR";
-bool entry_exists, extern_exists;
-label_ptr symbols_tbl;
-unsigned int data_memory[IMAGE_MEM_SIZE];
-unsigned int instr_memory[IMAGE_MEM_SIZE];
-int ic, dc;
-bool error_occured_flag;
-ext_ptr ext_list;
-
 /**
- * @return true if error exists in the global err variable, otherwise false.
+ * @param ctx the assembler context
+ * @return true if error exists in the current error of the context, otherwise false.
  */
-bool is_error_exists() {
-    return strcmp(curr_error_key, "NO_ERROR");
+bool is_error_exists(assembler_ctx *ctx) {
+    return ctx->curr_error != ERR_NO_ERROR;
 }
 
 /**
- * @brief prints error if exists in the global err variable
+ * @brief stores the error in the diagnostics buffer if exists in the current error of the context.
+ * the stored errors are printed together with flush_diagnostics.
  *
+ * @param ctx the assembler context
  * @param line_num the line number in which the error occured
  * @return true if there was an error, otherwise false.
  */
-bool print_error(int line_num) {
-    err *err_ptr = (err *)errors;
+bool report_error(assembler_ctx *ctx, int line_num) {
+    diagnostic *item;
 
-    if (is_error_exists()) {
-        do {
-            err_ptr++;
-        } while (strcmp(err_ptr->key, curr_error_key) && strcmp(err_ptr->key, "UNDEFINED"));
+    if (!is_error_exists(ctx))
+        return FALSE;
 
-        printf("\n#ERROR:(line %d) %s, Message: %s\n", line_num, err_ptr->key, err_ptr->message);
+    if (ctx->diagnostics.count == MAX_DIAGNOSTICS) {
+        ctx->diagnostics.dropped++;
         return TRUE;
     }
 
-    return FALSE;
+    item = &ctx->diagnostics.items[ctx->diagnostics.count++];
+    item->code = ctx->curr_error;
+    item->line_num = line_num;
+    item->column = 0;
+
+    /* the error was caused by the last token which was read from the current line */
+    if (ctx->curr_line != NULL && ctx->curr_token != NULL)
+        item->column = (int)(ctx->curr_token - ctx->curr_line) + 1;
+
+    return TRUE;
 }
 
 /**
- * @brief Sets an error, this error needs to be printed manually with the function print_error
+ * @brief Sets an error, this error needs to be reported manually with the function report_error
  *
- * @param err_key the key name of the error
+ * @param ctx the assembler context
+ * @param err_code the code of the error
  */
-void set_error(char *err_key) {
-    if (strcmp(err_key, "NO_ERROR"))
-        error_occured_flag = TRUE;
-    curr_error_key = (char *)malloc_w_check(strlen(err_key) + 1);
-    strcpy(curr_error_key, err_key);
+void set_error(assembler_ctx *ctx, int err_code) {
+    if (err_code != ERR_NO_ERROR)
+        ctx->error_occured_flag = TRUE;
+    ctx->curr_error = err_code;
 }
 
 /**
- * @brief set and print an error
+ * @brief set and report an error
  *
- * @param err_key the key name of the error
+ * @param ctx the assembler context
+ * @param err_code the code of the error
  * @param line_num the line number which this error occured
  */
-void throw_err(char *err_key, int line_num) {
-    set_error(err_key);
-    print_error(line_num);
+void throw_err(assembler_ctx *ctx, int err_code, int line_num) {
+    set_error(ctx, err_code);
+    report_error(ctx, line_num);
+}
+
+/**
+ * @brief starts reading a new line: clears the error and the last token position.
+ *
+ * @param ctx the assembler context
+ * @param line the new line, or NULL if the errors are not related to a line in the source.
+ */
+void begin_line(assembler_ctx *ctx, char *line) {
+    ctx->curr_line = line;
+    ctx->curr_token = NULL;
+    ctx->curr_error = ERR_NO_ERROR;
+}
+
+/**
+ * @brief marks a token in the current line as the last token which was read, for the column of errors.
+ *
+ * @param ctx the assembler context
+ * @param token pointer to the start of the token in the current line
+ */
+void mark_token(assembler_ctx *ctx, char *token) {
+    if (ctx->curr_line != NULL)
+        ctx->curr_token = token;
+}
+
+/**
+ * @brief prints all the errors which were stored for the current file to the log, and clears the buffer.
+ *
+ * @param ctx the assembler context
+ */
+void flush_diagnostics(assembler_ctx *ctx) {
+    int i;
+    diagnostic *item;
+    char message[MAX_MESSAGE_LENGTH]; /* the keys and messages of the errors table are short, so a message always fits */
+
+    for (i = 0; i < ctx->diagnostics.count; i++) {
+        item = &ctx->diagnostics.items[i];
+        if (item->line_num == 0) /* an error of the whole program */
+            sprintf(message, "\n#ERROR: %s, Message: %s\n", errors[item->code].key, errors[item->code].message);
+        else if (item->column > 0)
+            sprintf(message, "\n#ERROR:(line %d, column %d) %s, Message: %s\n", item->line_num, item->column, errors[item->code].key, errors[item->code].message);
+        else
+            sprintf(message, "\n#ERROR:(line %d) %s, Message: %s\n", item->line_num, errors[item->code].key, errors[item->code].message);
+        print_log(ctx, message);
+    }
+    if (ctx->diagnostics.dropped > 0) {
+        sprintf(message, "\n#ERROR: %d more errors were found.\n", ctx->diagnostics.dropped);
+        print_log(ctx, message);
+    }
+
+    ctx->diagnostics.count = 0;
+    ctx->diagnostics.dropped = 0;
+}
+
+/**
+ * @brief appends a message to the log of the assembly, instead of printing it directly to the console.
+ *
+ * @param ctx the assembler context
+ * @param text the message to append
+ */
+void print_log(assembler_ctx *ctx, char *text) {
+    text_buffer_append(ctx->log, text, strlen(text));
 }
@@ -2,17 +2,20 @@
 #define _GLOBAL_H
 
 /* Declarations */
-#define IC_INIT_ADDR 100
-#define IMAGE_MEM_SIZE 2560
-#define CODE_ARR_IMG_LENGTH 2560
+#define IC_INIT_ADDR 100                /* the default load base: the address of the first instruction */
+#define MEMORY_SIZE 1024                /* the addresses which are written as 2 digits of base 32 */
+#define MAX_LOAD_BASE (MEMORY_SIZE - 1) /* the largest address which is written as 2 digits of base 32 */
+#define MAX_MEMORY_SIZE MEMORY_SIZE     /* the largest memory which an object file can address */
 
 #define EXT_MAX_LEN 6
-#define MAX_LINE_LENGTH 82 /* Maximum length of a single source line  */
 #define REGISTER_LENGTH 2  /* a register's name contains 2 characters */
 #define MIN_REGISTER 0     /* r0 is the first register */
 #define MAX_REGISTER 7     /* r7 is the last register */
 #define NOT_FOUND -1
 
+#define MAX_DIAGNOSTICS 512 /* Maximum errors which are stored for a single file */
+#define MAX_MESSAGE_LENGTH 256 /* Maximum length of a formatted message of an error */
+
 #define LABEL_MAX_LEN 30
 #define OPERAND_MAX_LEN 20
 
@@ -81,53 +84,362 @@ typedef enum addressing_types {
     ADDR_UNKNOWN
 } addressing_type;
 
+/* bit of an addressing method in a set of methods (a missing operand is ADDR_UNKNOWN) */
+#define METHOD_BIT(method) (1U << (method))
+#define NO_OPERAND METHOD_BIT(ADDR_UNKNOWN)
+#define ANY_METHOD (METHOD_BIT(ADDR_IMMEDIATE) | METHOD_BIT(ADDR_DIRECT) | METHOD_BIT(ADDR_STRUCT) | METHOD_BIT(ADDR_REGISTER))
+#define MEMORY_METHOD (METHOD_BIT(ADDR_DIRECT) | METHOD_BIT(ADDR_STRUCT)) /* an operand which is an address */
+#define WRITABLE_METHOD (MEMORY_METHOD | METHOD_BIT(ADDR_REGISTER))        /* an operand which isn't an immediate */
+
+/* the description of a command of the instruction set */
+typedef struct {
+    int num_operands;          /* number of operands of the command (0, 1 or 2) */
+    unsigned int src_methods;  /* the allowed addressing methods of the source operand (METHOD_BIT) */
+    unsigned int dest_methods; /* the allowed addressing methods of the destination operand (METHOD_BIT) */
+} command_descriptor;
+
 enum ARE { ABSOLUTE,
            EXTERNAL,
            RELOCATABLE };
 
-/* Defining a circular double-linked list to store each time the program uses an extern label, and a pointer to that list */
-typedef struct ext *ext_ptr;
-typedef struct ext {
-    char name[LABEL_MAX_LEN]; /* the name of the extern label */
-    unsigned int address;     /* the address in memory where the external address should be replaced */
-    ext_ptr next;             /* a pointer to the next extern in the list */
-    ext_ptr prev;             /* a pointer to the previous extern in the list */
-} ext;
+/* the sections of the memory which labels are defined in. the address of a label is an offset in its section,
+ * which is relocated by the base of the section when it's read */
+enum sections { SECTION_CODE,   /* labels of instructions, the section starts at the load base */
+                SECTION_DATA,   /* labels of data, the section starts after the instructions */
+                SECTION_EXTERN, /* external labels, which have no address */
+                NUM_SECTIONS };
+
+/* a word of the instructions memory which holds the address of an external label */
+typedef struct {
+    int label_id;         /* id of the external label in the symbols table */
+    unsigned int address; /* index of the word in the instructions memory */
+} extern_ref;
+
+/* list of references to external labels by order of their addresses, a single array which is reused for every source */
+typedef struct {
+    extern_ref *items;
+    int count;
+    int capacity;
+} extern_ref_list;
+
+/* a 10 bits word of the memory */
+typedef unsigned short machine_word;
+
+/* a growable image of the memory (instructions or data), a word per address */
+typedef struct {
+    machine_word *words; /* the words of the image, NULL before the first word */
+    int capacity;        /* allocated length of the words array */
+} memory_image;
+
+/* a block of memory of an arena, the memory of the allocations follows its header */
+typedef struct arena_block {
+    struct arena_block *next; /* the previous block, the blocks are listed from the newest */
+    long size;                /* number of bytes in the block */
+    long used;                /* number of bytes which were allocated */
+} arena_block;
+
+/* bump-pointer allocator for the temporaries of a single source, which are all released at once */
+typedef struct {
+    arena_block *blocks; /* the blocks, the current block first, NULL before the first allocation */
+    long total;          /* number of bytes in all the blocks */
+} arena;
+
+/* pool of interned strings: each distinct name is stored once (null terminated) and is referred to by its id */
+typedef struct {
+    char *chars;           /* the strings */
+    long length;           /* number of characters in use */
+    long chars_capacity;   /* allocated size of chars */
+    long *offsets;         /* offset of each string in chars, by id */
+    unsigned long *hashes; /* hash of each string, by id */
+    int count;             /* number of strings */
+    int capacity;          /* allocated length of the offsets and hashes arrays */
+    int *slots;            /* hash index into the ids, EMPTY_POOL_SLOT for an empty slot */
+    int num_slots;         /* number of slots in the index, always a power of 2 */
+} string_pool;
 
-/* linked list of labels */
+/* a value for each id of a string pool (e.g. the id of the label which has the name) */
+typedef struct {
+    int *items;   /* the values by id, NOT_FOUND for an id without a value */
+    int count;    /* number of ids in the map, larger ids have no value */
+    int capacity; /* allocated length of the items array */
+} name_map;
+
+/* a single label (symbol) record */
 typedef struct strLabels *label_ptr;
 typedef struct strLabels {
-    char name[LABEL_MAX_LEN]; /* label name */
-    unsigned int address;     /* label address */
-    bool external;            /* a boolean type variable to store if the label is extern or not */
-    bool activeRow;           /* a boolean type varialbe to store if the label is in an action statement or not */
-    bool entry;               /* a boolean type varialbe to store if the label is entry or not */
-    label_ptr next;           /* a pointer to the next label in the list */
+    int name_id;         /* id of the label name in the pool of names */
+    int section;         /* the section of the label (code, data or extern) */
+    unsigned int offset; /* address of the label relative to the base of its section */
+    bool entry;          /* a boolean type varialbe to store if the label is entry or not */
+    bool defined;        /* a boolean type varialbe to store if the label was defined, or only referenced so far */
 } Labels;
 
+/* symbols table: labels are kept in an array, where the index of a label is its id,
+ * and are found by the id of their name in the pool of names.
+ * a label gets an id when it's first defined or referenced, so the order of definition
+ * (needed for the .ent output) is kept separately. */
+typedef struct {
+    Labels *labels;                          /* array of all labels, by id */
+    int *defined;                            /* ids of the defined labels by order of definition */
+    int count;                               /* number of labels in the array */
+    int num_defined;                         /* number of ids in the defined array */
+    int capacity;                            /* allocated length of the labels and defined arrays */
+    string_pool *names;                      /* the pool of the names of the source */
+    name_map label_ids;                      /* the id of the label of each name */
+    unsigned int section_base[NUM_SECTIONS]; /* the address which each section starts at */
+} symbols_table;
+
+/* growable buffer of text, such as the source code after expanding macros */
+typedef struct {
+    char *data;    /* the text, always null terminated */
+    long length;   /* length of the text (w/o the null terminator) */
+    long capacity; /* allocated size of data */
+} text_buffer;
+
+/* the content of a source file in memory */
+typedef struct {
+    char *data;         /* the content of the file (not null terminated when it's mapped) */
+    long length;        /* length of the content */
+    bool mapped;        /* true if the file is mapped to memory, otherwise the content was read to the buffer */
+    text_buffer buffer; /* the content of a file which can't be mapped (e.g. a pipe) */
+} source_file;
+
+/* a line of a text, as a span of the text (lines are not copied) */
+typedef struct {
+    long start;  /* offset of the first character of the line in the text */
+    long length; /* length of the line, incl. its new line character (the last line may not have one) */
+} line_span;
+
+/* Kernels which scan a text for its lines and the classes of its characters */
+enum scan_kernels { SCAN_SCALAR, /* a character at a time, on any machine */
+                    SCAN_SSE2,   /* 16 characters at a time (x86-64) */
+                    SCAN_AVX2 }; /* 32 characters at a time (x86-64 processors which support AVX2) */
+
+/* the lines of a text, and bitmaps of the classes of its characters (bit i of a bitmap is character i of the text,
+ * so the bits of a line start at its offset). the arrays are reused for all the texts */
+typedef struct {
+    line_span *items;          /* the lines by order */
+    long count;                /* number of lines */
+    long capacity;             /* allocated length of the items array */
+    unsigned long *spaces;     /* bit is set for a whitespace character */
+    unsigned long *separators; /* bit is set for a whitespace character or a comma */
+    long bitmap_capacity;      /* allocated number of words in each bitmap */
+    int kernel;                /* the kernel which scans the text (enum scan_kernels) */
+} line_index;
+
+/* Kinds of the tokens of a line */
+enum token_kinds { TOKEN_WORD,      /* a run of characters which isn't a number (e.g. a label, a command or an operand) */
+                   TOKEN_NUMBER,    /* a number with an optional sign */
+                   TOKEN_IMMEDIATE, /* '#' followed by a number */
+                   TOKEN_COMMA };   /* a single comma */
+
+/* a token of a line: a single comma, or a run of characters which are neither whitespaces nor commas */
+typedef struct {
+    int kind;    /* kind of the token (enum token_kinds) */
+    int offset;  /* offset of the first character of the token in the line */
+    int length;  /* number of characters in the token */
+    int value;   /* the value of a number or an immediate, otherwise 0 */
+    bool joined; /* true if the token follows the previous one without whitespaces (they are parts of the same word) */
+} token;
+
+/* the tokens of a single line, the array is reused for all the lines */
+typedef struct {
+    char *line;   /* the line which was tokenized, the offsets of the tokens are relative to it */
+    token *items; /* the tokens by order of the line */
+    int count;    /* number of tokens in the line */
+    int capacity; /* allocated length of the items array */
+} token_list;
+
+/* an operand of an instruction, as it was parsed in stage 1 */
+typedef struct {
+    int method;   /* addressing method (enum addressing_types), ADDR_UNKNOWN if there is no operand */
+    int value;    /* the number of a register, the value of an immediate, or the field of a struct */
+    int label_id; /* id of the label of a direct or a struct operand in the symbols table, otherwise NOT_FOUND */
+} operand;
+
+/* a command of the source, which is recorded in stage 1 and encoded when the symbols table is complete */
+typedef struct {
+    int opcode;           /* the command (enum commands) */
+    operand src;          /* the source operand */
+    operand dest;         /* the destination operand (a single operand is a destination) */
+    unsigned int address; /* index of the first word of the instruction in the instructions memory */
+    int line_num;         /* the line of the instruction, for error messages */
+} instruction;
+
+/* list of instructions by order of the source file */
+typedef struct {
+    instruction *items;
+    int count;
+    int capacity;
+} instruction_list;
+
+/* a range of instructions which is encoded separately from the other ranges, once the symbols table is complete */
+typedef struct {
+    symbols_table *symbols_tbl; /* the symbols table, which isn't changed while encoding */
+    machine_word *memory;       /* the words of the instructions memory */
+    instruction *first;         /* the first instruction of the slice */
+    instruction *end;           /* the instruction after the last instruction of the slice */
+    extern_ref_list externs;    /* the references to external labels in the slice, by order of their addresses */
+    int num_unresolved;         /* number of operands whose label isn't defined */
+} instruction_slice;
+
+/* an .entry directive, which is resolved when the symbols table is complete */
+typedef struct {
+    int label_id; /* id of the label in the symbols table, NOT_FOUND if it can't be a label */
+    int line_num; /* the line of the directive, for error messages */
+} fixup;
+
+/* list of fixups by order of their lines in the source file */
+typedef struct {
+    fixup *items;
+    int count;
+    int capacity;
+} fixup_list;
+
+/* Error codes, each code is the index of its key and message in the errors table */
+enum error_codes { ERR_NO_ERROR,
+                   ERR_LABEL_FIRST_CHAR_IS_LETTER,
+                   ERR_LABEL_ONLY_ALPHANUMERIC,
+                   ERR_LABEL_MAX_LENGTH,
+                   ERR_ONLY_LABEL_IN_LINE,
+                   ERR_INSTRUCTION_NOT_FOUND,
+                   ERR_DIRECTIVE_NO_OPERANDS,
+                   ERR_DIRECTIVE_INVALID_NUM_PARAMS,
+                   ERR_LABEL_INSERT_FAILED,
+                   ERR_LABEL_ALREADY_EXISTS,
+                   ERR_DATA_EXPECTED_NUM,
+                   ERR_DATA_COMMAS_IN_A_ROW,
+                   ERR_STRING_TOO_MANY_OPERANDS,
+                   ERR_STRING_OPERAND_NOT_VALID,
+                   ERR_STRUCT_INVALID_STRING,
+                   ERR_EXTERN_NO_LABEL,
+                   ERR_EXTERN_INVALID_LABEL,
+                   ERR_EXTERN_TOO_MANY_OPERANDS,
+                   ERR_COMMAND_UNEXPECTED_CHAR,
+                   ERR_COMMAND_LABEL_DOES_NOT_EXIST,
+                   ERR_FAILED_OPEN_FILE,
+                   ERR_COMMAND_INVALID_METHOD,
+                   ERR_COMMAND_INVALID_NUMBER_OF_OPERANDS,
+                   ERR_COMMAND_INVALID_OPERANDS_METHODS,
+                   ERR_COMMAND_TOO_MANY_OPERANDS,
+                   ERR_DATA_EXPECTED_COMMA_AFTER_NUM,
+                   ERR_ENTRY_CANT_BE_EXTERN,
+                   ERR_EXPECTED_COMMA_BETWEEN_OPERANDS,
+                   ERR_LABEL_DOES_NOT_EXIST,
+                   ERR_STRUCT_EXPECTED_STRING,
+                   ERR_STRUCT_INVALID_NUM,
+                   ERR_STRUCT_TOO_MANY_OPERANDS,
+                   ERR_MEMORY_OVERFLOW,
+                   ERR_UNDEFINED,
+                   NUM_ERRORS };
+
 typedef struct {
     char *key;
     char *message;
 } err;
 
+/* an error which occured in a file, stored until all the errors of the file are printed */
+typedef struct {
+    int code;     /* the error code (enum error_codes) */
+    int line_num; /* the line in which the error occured */
+    int column;   /* the column of the token which caused the error, 0 if unknown */
+} diagnostic;
+
+/* preallocated buffer of the errors of a single file */
+typedef struct {
+    diagnostic items[MAX_DIAGNOSTICS];
+    int count;   /* number of stored errors */
+    int dropped; /* number of errors which didn't fit in the buffer */
+} diagnostics_buffer;
+
+/* a macro, its content is a span in the arena of the macro table */
+typedef struct Macro *macro_ptr;
+typedef struct Macro {
+    int name_id;         /* id of the macro unique name in the pool of names */
+    long content_offset; /* offset of the content of the macro to expand in the arena */
+    long content_length; /* length of the content */
+} macro_list;
+
+/* table of macros, which are found by the id of their name in the pool of names */
+typedef struct {
+    macro_list *macros; /* array of all the macros by order of definition */
+    int count;          /* number of macros */
+    int capacity;       /* allocated length of the macros array */
+    string_pool *names; /* the pool of the names of the source */
+    name_map macro_ids; /* the index of the macro of each name in the macros array */
+    text_buffer arena;  /* contents of all the macros */
+} macro_table;
+
+/* the whole state of the assembler while assembling a single source.
+ * every function which reads or changes this state gets the context, so any number of
+ * contexts can be used in the same process (one after another, or at the same time). */
+typedef struct {
+    /* text */
+    line_index lines;  /* the lines of the text which is processed (the source, or the expanded source) */
+    token_list tokens; /* the tokens of the current line */
+    string_pool names; /* the names of the labels and macros of the source */
+    arena temps;       /* the temporaries of the source (e.g. filenames), released when the source is done */
+
+    /* pre-processor */
+    macro_table macros;           /* the macros which were defined so far */
+    bool reading_macro;           /* true while reading the lines of a macro definition */
+    macro_ptr curr_macro;         /* the macro which the lines are added to, NULL if its name was invalid */
+    text_buffer *expanded_source; /* the source after expanding macros */
+
+    /* stages 1 and 2 */
+    int num_threads;        /* number of threads which assemble a large source, 1 for a single thread */
+    unsigned int load_base; /* the address of the first instruction (IC_INIT_ADDR by default) */
+    int memory_size;        /* number of addresses which the program must fit in (MEMORY_SIZE by default), 0 for any
+                               (only to measure the stages: an object is never written past MEMORY_SIZE) */
+    bool unchecked_label;   /* a label before .entry or .extern wasn't checked against the labels of previous chunks */
+    symbols_table symbols_tbl;
+    instruction_list instructions;
+    fixup_list fixups;
+    extern_ref_list externs; /* the references to external labels, by order of their addresses */
+    bool entry_exists, extern_exists;
+    memory_image data_memory;
+    memory_image instr_memory;
+    int ic;
+    int dc;
+
+    /* errors */
+    bool error_occured_flag;
+    int curr_error;
+    char *curr_line, *curr_token;
+    diagnostics_buffer diagnostics;
+
+    text_buffer *log; /* the messages of the assembly, which are printed to the console by the executable */
+} assembler_ctx;
+
+/* the output of assembling a single source, in memory */
+typedef struct {
+    text_buffer expanded;    /* the source after expanding macros (the content of the .am file) */
+    text_buffer object;      /* the content of the .ob file */
+    text_buffer entries;     /* the content of the .ent file */
+    text_buffer externals;   /* the content of the .ext file */
+    bool has_output;         /* true if there were no errors, so the output files should be written */
+    bool has_entries;        /* true if there is a .ent file */
+    bool has_externals;      /* true if there is a .ext file */
+    diagnostic *diagnostics; /* the errors which were found (upto MAX_DIAGNOSTICS), by order of lines */
+    int num_diagnostics;     /* number of errors in the diagnostics array */
+    text_buffer log;         /* the messages of the assembly, incl. the errors */
+} assembly_result;
+
 extern const char base32[];
 extern const char *commands[];
+extern const command_descriptor command_set[];
+extern const int operand_words[];
 extern const char *directives[];
 extern const err errors[];
-extern bool error_occured_flag;
-extern label_ptr symbols_tbl;
-extern bool entry_exists, extern_exists;
-extern ext_ptr ext_list;
-extern char *curr_error_key;
-extern unsigned int data_memory[];
-extern unsigned int instr_memory[];
-extern int ic;
-extern int dc;
 
 /* Prototypes */
-bool is_error_exists();
-bool print_error(int line_num);
-void set_error(char *err_key);
-void throw_err(char *err_key, int line_num);
+bool is_error_exists(assembler_ctx *ctx);
+bool report_error(assembler_ctx *ctx, int line_num);
+void set_error(assembler_ctx *ctx, int err_code);
+void throw_err(assembler_ctx *ctx, int err_code, int line_num);
+void begin_line(assembler_ctx *ctx, char *line);
+void mark_token(assembler_ctx *ctx, char *token);
+void flush_diagnostics(assembler_ctx *ctx);
+void print_log(assembler_ctx *ctx, char *text);
 
 #endif
@@ -0,0 +1,58 @@
+/**
+ * @file instruction_list.c
+ * @brief this file includes all the functions which are managing the list of instructions.
+ * stage 1 parses each command to a fixed size record (the command, the addressing methods and the values of its
+ * operands, its address and its line), and stage 2 encodes the words of the instructions from the records, when
+ * the addresses of all the labels are known, without reading the source again.
+ */
+
+#include "instruction_list.h"
+
+/**
+ * @brief initialize an empty instructions list
+ *
+ * @param list the list to initialize
+ */
+void instructions_init(instruction_list *list) {
+    list->count = 0;
+    list->capacity = INSTRUCTIONS_INIT_CAPACITY;
+    list->items = (instruction *)malloc_w_check(sizeof(instruction) * list->capacity);
+}
+
+/**
+ * @brief free memory allocation of a given instructions list
+ *
+ * @param list the list to free
+ */
+void instructions_free(instruction_list *list) {
+    free(list->items);
+    list->items = NULL;
+    list->count = list->capacity = 0;
+}
+
+/**
+ * @brief function which adds an instruction to the end of the list
+ *
+ * @param list the list to insert to
+ * @return instruction* the new record, to be filled by the caller
+ */
+instruction *add_instruction(instruction_list *list) {
+    if (list->count == list->capacity) {
+        list->capacity *= 2;
+        list->items = (instruction *)realloc_w_check(list->items, sizeof(instruction) * list->capacity);
+    }
+    return &list->items[list->count++];
+}
+
+/**
+ * @brief function which calculates the number of words of an instruction in the instructions memory
+ *
+ * @param instr the instruction
+ * @return int the number of words, incl. the first word
+ */
+int instruction_length(instruction *instr) {
+    /* There's a special case where 2 register operands share the same additional word */
+    if (instr->src.method == ADDR_REGISTER && instr->dest.method == ADDR_REGISTER)
+        return 2;
+    return 1 + operand_words[instr->src.method] + operand_words[instr->dest.method];
+}
@@ -0,0 +1,17 @@
+#ifndef INSTRUCTION_LIST_H
+#define INSTRUCTION_LIST_H
+
+#include "global.h"
+#include "utils.h"
+#include <stdlib.h>
+
+/* Declarations */
+#define INSTRUCTIONS_INIT_CAPACITY 256 /* initial length of the instructions array */
+
+/* Prototypes */
+void instructions_init(instruction_list *list);
+void instructions_free(instruction_list *list);
+instruction *add_instruction(instruction_list *list);
+int instruction_length(instruction *instr);
+
+#endif
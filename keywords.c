@@ -0,0 +1,98 @@
+/**
+ * @file keywords.c
+ * @brief this file includes the classifier of reserved words (commands, directives, registers and base32 digits).
+ * each kind of reserved word has a different length, so the classifier switches on the length of the word
+ * and then uses a collision-free hash table of that length, so a word is compared to one keyword at most.
+ *
+ * The tables below were generated from the tables in global.c (commands[], directives[], base32[]),
+ * they must be regenerated if those tables change.
+ */
+
+#include "keywords.h"
+#include <string.h>
+
+/* Perfect hash of the commands: (word[0] + 18 * word[2]) & 31 -> opcode */
+#define COMMAND_HASH(w) (((unsigned char)(w)[0] + 18 * (unsigned char)(w)[2]) & 31)
+static const signed char command_hash[32] = {
+    -1, -1, -1, CMP, -1, -1, -1, CLR, RTS, ADD, JMP, -1, PRN, -1, JSR, GET,
+    HLT, -1, -1, -1, -1, -1, NOT, SUB, -1, MOV, DEC, -1, BNE, -1, LEA, INC};
+
+/* Perfect hash of the directives: (word[1] + word[4]) & 7 -> directive type */
+#define DIRECTIVE_HASH(w) (((unsigned char)(w)[1] + (unsigned char)(w)[4]) & 7)
+static const signed char directive_hash[8] = {
+    STRUCT, -1, EXTERN, -1, STRING, DATA, -1, ENTRY};
+
+/* Reverse lookup of base32[]: character -> digit value */
+static const signed char base32_index[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1,  0, -1,  2,  3,  4,  6, -1, -1, -1,  7, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  8, -1,  9, -1,
+     1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  5, -1,
+    -1, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+    25, 26, 27, 28, 29, 30, 31, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+
+/**
+ * @brief classifies a word as a command, directive, register, base32 digit or identifier.
+ * the word is a span of a line, so it isn't null terminated.
+ *
+ * @param word pointer to the first character of the word
+ * @param len the number of characters in the word
+ * @return keyword the kind of the word and its index in the matching table
+ */
+keyword classify_span(char *word, int len) {
+    keyword result;
+    int index;
+
+    result.kind = WORD_IDENTIFIER;
+    result.index = NOT_FOUND;
+
+    switch (len) {
+    case 1: /* base32 digit */
+        index = base32_index[(unsigned char)word[0]];
+        if (index != NOT_FOUND) {
+            result.kind = WORD_BASE32;
+            result.index = index;
+        }
+        break;
+
+    case REGISTER_LENGTH: /* register r0 - r7 */
+        if (word[0] == 'r' && word[1] >= '0' && word[1] < '0' + MAX_REGISTER + 1) {
+            result.kind = WORD_REGISTER;
+            result.index = word[1] - '0';
+        }
+        break;
+
+    case 3: /* command */
+        index = command_hash[COMMAND_HASH(word)];
+        if (index != NOT_FOUND && word[0] == commands[index][0] && word[1] == commands[index][1] &&
+            word[2] == commands[index][2]) {
+            result.kind = WORD_COMMAND;
+            result.index = index;
+        }
+        break;
+
+    case 5: /* directive */
+    case 6:
+    case 7:
+        if (word[0] != '.')
+            break;
+        index = directive_hash[DIRECTIVE_HASH(word)];
+        if (index != NOT_FOUND && !strncmp(directives[index], word, len) && directives[index][len] == '\0') {
+            result.kind = WORD_DIRECTIVE;
+            result.index = index;
+        }
+        break;
+    }
+
+    return result;
+}
@@ -0,0 +1,24 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include "global.h"
+
+/* Kind of a word in the source code */
+typedef enum {
+    WORD_IDENTIFIER, /* not a reserved word (e.g. label or macro name) */
+    WORD_COMMAND,    /* command name, index is its opcode (enum commands) */
+    WORD_DIRECTIVE,  /* directive name, index is its type (enum directives) */
+    WORD_REGISTER,   /* register name, index is the register number */
+    WORD_BASE32      /* a single base32 digit, index is its value */
+} word_kind;
+
+/* Result of classifying a word */
+typedef struct {
+    word_kind kind;
+    int index; /* index of the word in its table, NOT_FOUND for identifiers */
+} keyword;
+
+/* Prototypes */
+keyword classify_span(char *word, int len);
+
+#endif
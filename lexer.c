@@ -0,0 +1,188 @@
+/**
+ * @file lexer.c
+ * @brief this file includes the lexer of the assembler, which splits a line to tokens.
+ * the line is a span of a text which was split by the scanner, and a token is a single comma, or a run of characters
+ * which are neither whitespaces nor commas (both are found by the bitmaps of the scanner). tokens are
+ * spans (offset and length) in the line, so nothing is copied, and numbers are parsed while they are scanned.
+ * tokens which aren't separated by whitespaces are marked as joined, so the whitespace separated words of the
+ * line (such as a label and the instruction) are runs of joined tokens.
+ */
+
+#include "lexer.h"
+
+/**
+ * @brief parses a number with an optional sign, like atoi, but without reading after its last digit
+ * (the line may be the end of a mapped file). a number which is out of range is saturated like atoi.
+ *
+ * @param str the first character of the number
+ * @param length the number of characters
+ * @return int the value of the number
+ */
+static int parse_number(const char *str, long length) {
+    long number = 0;
+    bool negative = *str == '-';
+    long i = (*str == '-' || *str == '+') ? 1 : 0;
+
+    for (; i < length; i++) {
+        if (number > (LONG_MAX - (str[i] - '0')) / 10)
+            return (int)(negative ? LONG_MIN : LONG_MAX);
+        number = number * 10 + (str[i] - '0');
+    }
+    return (int)(negative ? -number : number);
+}
+
+/**
+ * @brief initialize an empty token list
+ *
+ * @param tokens the list to initialize
+ */
+void tokens_init(token_list *tokens) {
+    tokens->line = NULL;
+    tokens->count = 0;
+    tokens->capacity = TOKENS_INIT_CAPACITY;
+    tokens->items = (token *)malloc_w_check(sizeof(token) * tokens->capacity);
+}
+
+/**
+ * @brief free memory allocation of a given token list
+ *
+ * @param tokens the list to free
+ */
+void tokens_free(token_list *tokens) {
+    free(tokens->items);
+    tokens->items = NULL;
+    tokens->count = tokens->capacity = 0;
+}
+
+/**
+ * @brief splits a line of a scanned text to tokens, replacing the previous tokens in the list.
+ * runs of whitespaces are skipped, and the end of a token is found, by the bitmaps of the text.
+ * a token which is made of an optional sign and digits is a number, and '#' followed by a number is an
+ * immediate, the value of both is parsed as the token is scanned.
+ *
+ * @param tokens the list to fill
+ * @param lines the lines of the text, and its bitmaps
+ * @param text the text
+ * @param index the index of the line in the text
+ */
+void tokenize_line(token_list *tokens, line_index *lines, char *text, long index) {
+    long start = lines->items[index].start;
+    long end = start + lines->items[index].length; /* the new line character is a whitespace */
+    long i = start, number_start, token_end;
+    char *line = text + start;
+    int digits;
+    bool is_number;
+    token *tok;
+
+    tokens->line = line;
+    tokens->count = 0;
+
+    while ((i = next_clear_bit(lines->spaces, i, end)) < end) {
+        if (tokens->count == tokens->capacity) {
+            tokens->capacity *= 2;
+            tokens->items = (token *)realloc_w_check(tokens->items, sizeof(token) * tokens->capacity);
+        }
+        tok = &tokens->items[tokens->count++];
+        tok->kind = TOKEN_WORD;
+        tok->offset = (int)(i - start);
+        tok->value = 0;
+        tok->joined = tokens->count > 1 && !BIT_IS_SET(lines->spaces, i - 1);
+
+        /* A comma is a separate, single-character token */
+        if (text[i] == ',') {
+            tok->kind = TOKEN_COMMA;
+            tok->length = 1;
+            i++;
+            continue;
+        }
+
+        token_end = next_set_bit(lines->separators, i, end);
+        tok->length = (int)(token_end - i);
+
+        /* the number of an immediate starts after the '#' */
+        number_start = text[i] == '#' ? i + 1 : i;
+        is_number = TRUE;
+        digits = 0;
+        for (i = number_start; i < token_end && is_number; i++) {
+            if (isdigit((unsigned char)text[i]))
+                digits++;
+            else if (i != number_start || (text[i] != '+' && text[i] != '-'))
+                is_number = FALSE; /* a sign can only be the first character of a number */
+        }
+        if (is_number && digits > 0) {
+            tok->kind = number_start == start + tok->offset ? TOKEN_NUMBER : TOKEN_IMMEDIATE;
+            tok->value = parse_number(text + number_start, token_end - number_start);
+        }
+        i = token_end;
+    }
+}
+
+/**
+ * @brief finds the end of the whitespace separated word which starts at a given token.
+ * e.g. in "mov r1,r2" the tokens "r1", "," and "r2" are a single word.
+ *
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the word
+ * @return int index of the token after the word
+ */
+int word_end(token_list *tokens, int first) {
+    int i = first + 1;
+
+    if (first >= tokens->count)
+        return first;
+    while (i < tokens->count && tokens->items[i].joined)
+        i++;
+    return i;
+}
+
+/**
+ * @brief finds the end of a string operand which starts at a given token.
+ * a string which starts with a quote continues until a token which ends with a quote (whitespaces and commas
+ * may be inside of it), or until the end of the line. any other operand is a single token.
+ *
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operand
+ * @return int index of the token after the operand
+ */
+int string_end(token_list *tokens, int first) {
+    int i = first;
+    token *tok;
+
+    if (first >= tokens->count)
+        return first;
+    if (*TOKEN_TEXT(tokens, first) != '"')
+        return first + 1;
+
+    do {
+        tok = &tokens->items[i++];
+    } while (i < tokens->count && tokens->line[tok->offset + tok->length - 1] != '"');
+    return i;
+}
+
+/**
+ * @brief function which checks if the tokens of an operand are a valid string (wrapped with "").
+ * the whitespaces between the tokens are not a part of the string.
+ *
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operand
+ * @param end index of the token after the operand
+ * @return true if string, otherwise false.
+ */
+bool is_string_operand(token_list *tokens, int first, int end) {
+    int i, j, quotes = 0;
+    token *last;
+
+    if (first >= end)
+        return FALSE;
+
+    for (i = first; i < end; i++) {
+        for (j = 0; j < tokens->items[i].length; j++) {
+            if (TOKEN_TEXT(tokens, i)[j] == '"')
+                quotes++;
+        }
+    }
+
+    /* a string starts with a quote, and ends with the next quote */
+    last = &tokens->items[end - 1];
+    return *TOKEN_TEXT(tokens, first) == '"' && tokens->line[last->offset + last->length - 1] == '"' && quotes == 2;
+}
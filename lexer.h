@@ -0,0 +1,30 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "global.h"
+#include "scanner.h"
+#include "utils.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define TOKENS_INIT_CAPACITY 64 /* initial length of the tokens array, it grows for longer lines */
+
+/* pointer to the first character of the i-th token of a token list */
+#define TOKEN_TEXT(tokens, i) ((tokens)->line + (tokens)->items[i].offset)
+
+/* number of characters in the line from the first token to the end of the last token (first < end) */
+#define TOKENS_LENGTH(tokens, first, end) \
+    ((tokens)->items[(end)-1].offset + (tokens)->items[(end)-1].length - (tokens)->items[first].offset)
+
+/* Prototypes */
+void tokens_init(token_list *tokens);
+void tokens_free(token_list *tokens);
+void tokenize_line(token_list *tokens, line_index *lines, char *text, long index);
+int word_end(token_list *tokens, int first);
+int string_end(token_list *tokens, int first);
+bool is_string_operand(token_list *tokens, int first, int end);
+
+#endif
@@ -10,101 +10,149 @@
  *
  */
 
-#include "pre_processor.h"
-#include "stage_1.h"
-#include "stage_2.h"
+#include "batch.h"
+#include "server.h"
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define OPTION_EMIT_AM "--emit-am"         /* write the source after expanding macros to a .am file */
+#define OPTION_JOBS "-j"                   /* -j N: assemble N files at the same time, or split the first pass of fewer files */
+#define OPTION_LOAD_BASE "--load-base"     /* --load-base N: the address of the first instruction (100 by default) */
+#define OPTION_MEMORY_SIZE "--memory-size" /* --memory-size N: the number of addresses, upto 1024 (1024 by default) */
+#define OPTION_CACHE_DIR "--cache-dir"     /* --cache-dir DIR: skip assembling the files which are in the build cache */
+#define OPTION_CACHE_STATS "--cache-stats" /* print the hits and misses of the build cache, and the time it saved */
+#define OPTION_SERVE "--serve"             /* --serve SOCKET: assemble the requests of clients on a unix socket */
+#define OPTION_CLIENT "--client"           /* --client SOCKET: send the files to the server on a unix socket */
 
 /* Prototypes */
-static status process_file(char *filename, int file_count);
+static bool is_option(const char *arg);
+static int parse_number(const char *value, int max);
 
 /**
  * @brief calling assembler to interpret the given files in args.
+ * the executable is a wrapper of the assembler library, which reads the source files and writes the output files.
  */
 int main(int argc, char const *argv[]) {
 
     int i;
-    status succeeded = NO_ERROR;
+    char **filenames;
+    int file_count = 0;
+    int num_jobs = 1;
+    int load_base = IC_INIT_ADDR;
+    int memory_size = MEMORY_SIZE;
+    char *cache_dir = NULL;
+    char *serve_socket = NULL;
+    bool cache_stats = FALSE;
+    build_cache cache;
+    batch_options options;
     printf("\nLets do it!\n");
 
-    /* Check if the user entered mandatory filenames */
-    if (argc <= 1) {
-        printf("\nYou must specify file name in command line!\n");
-        exit(0);
-    }
+    filenames = (char **)malloc_w_check(sizeof(char *) * argc);
+    options.emit_am = FALSE;
+    options.cache = NULL;
+    options.server = NULL;
 
+    /* Read options, and collect the filenames */
     for (i = 1; i < argc; i++) {
-        succeeded = process_file((char *)argv[i], i);
-        if (!succeeded)
-            printf("The assembler failed on file: %s", argv[i]);
+        if (!is_option(argv[i]))
+            filenames[file_count++] = (char *)argv[i];
+        else if (!strcmp(argv[i], OPTION_EMIT_AM))
+            options.emit_am = TRUE;
+        else if (!strcmp(argv[i], OPTION_CACHE_STATS))
+            cache_stats = TRUE;
+        else if (!strcmp(argv[i], OPTION_CACHE_DIR) && i + 1 < argc)
+            cache_dir = (char *)argv[++i];
+        else if (!strcmp(argv[i], OPTION_SERVE) && i + 1 < argc)
+            serve_socket = (char *)argv[++i];
+        else if (!strcmp(argv[i], OPTION_CLIENT) && i + 1 < argc)
+            options.server = (char *)argv[++i];
+        else if (!strcmp(argv[i], OPTION_MEMORY_SIZE) && i + 1 < argc && (memory_size = parse_number(argv[i + 1], MAX_MEMORY_SIZE)) > 0)
+            i++;
+        else if (!strcmp(argv[i], OPTION_LOAD_BASE) && i + 1 < argc && (load_base = parse_number(argv[i + 1], MAX_LOAD_BASE)) >= 0)
+            i++;
+        else if (!strcmp(argv[i], OPTION_JOBS) && i + 1 < argc && (num_jobs = parse_number(argv[i + 1], MAX_JOBS)) > 0)
+            i++;
+        else if (!strncmp(argv[i], OPTION_JOBS, strlen(OPTION_JOBS)) && (num_jobs = parse_number(argv[i] + strlen(OPTION_JOBS), MAX_JOBS)) > 0)
+            continue;
+        else {
+            printf("\nUnknown option: %s\n", argv[i]);
+            exit(1);
+        }
     }
 
-    return 0;
-}
+    if (!valid_memory_options((unsigned int)load_base, memory_size)) {
+        printf("\n%s must be less than %s\n", OPTION_LOAD_BASE, OPTION_MEMORY_SIZE);
+        exit(1);
+    }
 
-/**
- * Processes a single assembly source file, and returns the result status.
- * @param filename The filename, without it's extension
- * @param file_count the number of the file in order.
- * @return Whether succeeded or not.
- */
-static status process_file(char *filename, int file_count) {
-    char *input_filename;
-    FILE *fd; /* Current assembly file descriptor to process */
-    entry_exists = FALSE;
-    extern_exists = FALSE;
-    error_occured_flag = FALSE;
-    ext_list = NULL;
-    symbols_tbl = NULL;
-
-    /* add filename extension, ".as" */
-    input_filename = str_alloc_concat(filename, ".as");
-
-    /* title */
-    printf("\n\n ___\n");
-    printf("|#%2d| File: %s                \n", file_count, input_filename);
-    printf(" ‾‾‾  ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾");
-
-    fd = fopen(input_filename, "r");
-    if (fd == NULL) {
-        /* file couldn't be opened. */
-        printf("Error: There is a problem with the file \"%s.as\". skipping to the next one... \n", filename);
-        free(input_filename);
-        return FAILED;
+    if (cache_stats && cache_dir == NULL) {
+        printf("\n%s must be used with %s\n", OPTION_CACHE_STATS, OPTION_CACHE_DIR);
+        exit(1);
     }
 
-    /* Pre-processor: expanding macros */
-    pre_processor(fd, filename);
+    /* a server assembles the files of its clients, until it's stopped */
+    if (serve_socket != NULL) {
+        run_server(serve_socket, num_jobs);
+        printf("\nCan't serve on the socket: %s\n", serve_socket);
+        exit(1);
+    }
 
-    /* cleanup before next stage */
-    fclose(fd);
+    /* Check if the user entered mandatory filenames */
+    if (file_count == 0) {
+        printf("\nYou must specify file name in command line!\n");
+        exit(0);
+    }
 
-    /* open .am file with macros */
-    input_filename = str_alloc_concat(filename, ".am");
-    fd = fopen(input_filename, "r");
-    if (fd == NULL) {
-        /* file couldn't be opened. */
-        printf("Error: There is a problem with the file \"%s.as\". skipping to the next one... \n", filename);
-        free(input_filename);
-        return FAILED;
+    if (cache_dir != NULL) {
+        if (!cache_init(&cache, cache_dir, (unsigned int)load_base, memory_size)) {
+            printf("\nCan't use the cache directory: %s\n", cache_dir);
+            exit(1);
+        }
+        options.cache = &cache;
     }
 
-    /* Stage 1: Compiler  */
-    stage_1(fd, filename);
+    fflush(stdout);
+    options.load_base = (unsigned int)load_base;
+    options.memory_size = memory_size;
+    run_batch(filenames, file_count, num_jobs, &options);
+    free(filenames);
 
-    /* Stage 2: Wrapper */
-    if (!error_occured_flag) {
-        rewind(fd);
-        stage_2(fd, filename);
+    if (cache_dir != NULL) {
+        if (cache_stats)
+            cache_print_stats(&cache);
+        cache_free(&cache);
     }
 
-    printf("\n\nClosing file '%s'\n", filename);
-    printf("‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
+    return 0;
+}
 
-    fclose(fd);
-    free(input_filename);
+/**
+ * @param arg an argument from the command line
+ * @return true if the argument is an option (starts with "--" or "-j"), otherwise false.
+ */
+static bool is_option(const char *arg) {
+    return arg[0] == '-' && (arg[1] == '-' || arg[1] == OPTION_JOBS[1]);
+}
 
-    return SUCCESS;
+/**
+ * @param value the value of a numeric option (e.g. -j)
+ * @param max the largest valid value
+ * @return int the value, or -1 if it isn't a number between 0 and max.
+ */
+static int parse_number(const char *value, int max) {
+    int number = 0;
+
+    if (*value == '\0')
+        return -1;
+    for (; *value != '\0'; value++) {
+        if (*value < '0' || *value > '9')
+            return -1;
+        number = number * 10 + (*value - '0');
+        if (number > max)
+            return -1;
+    }
+    return number;
 }
@@ -0,0 +1,45 @@
+/**
+ * @file memory_image.c
+ * @brief this file includes the functions which are managing the memory images (instructions and data).
+ * an image holds a 10 bits word in 16 bits per address, and grows as words are written to it, so the size of a
+ * program is limited only by the memory size of the context, which is checked (and reported) by stage 1.
+ */
+
+#include "memory_image.h"
+
+/**
+ * @brief initialize an empty image, its words are allocated by the first reservation
+ *
+ * @param image the image to initialize
+ */
+void image_init(memory_image *image) {
+    image->words = NULL;
+    image->capacity = 0;
+}
+
+/**
+ * @brief free memory allocation of a given image
+ *
+ * @param image the image to free
+ */
+void image_free(memory_image *image) {
+    free(image->words);
+    image->words = NULL;
+    image->capacity = 0;
+}
+
+/**
+ * @brief makes sure that an image can hold a given number of words, the image keeps its words as it grows
+ *
+ * @param image the image
+ * @param count the number of words
+ */
+void image_reserve(memory_image *image, int count) {
+    if (count <= image->capacity)
+        return;
+    if (image->capacity == 0)
+        image->capacity = IMAGE_INIT_CAPACITY;
+    while (count > image->capacity)
+        image->capacity *= 2;
+    image->words = (machine_word *)realloc_w_check(image->words, sizeof(machine_word) * image->capacity);
+}
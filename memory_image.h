@@ -0,0 +1,16 @@
+#ifndef MEMORY_IMAGE_H
+#define MEMORY_IMAGE_H
+
+#include "global.h"
+#include "utils.h"
+#include <stdlib.h>
+
+/* Declarations */
+#define IMAGE_INIT_CAPACITY 1024 /* initial number of words of an image, allocated by its first reservation */
+
+/* Prototypes */
+void image_init(memory_image *image);
+void image_free(memory_image *image);
+void image_reserve(memory_image *image, int count);
+
+#endif
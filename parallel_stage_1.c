@@ -0,0 +1,212 @@
+/**
+ * @file parallel_stage_1.c
+ * @brief this file includes the first pass over a large source in parallel.
+ * the source is split at line boundaries to chunks of about the same size, and each chunk is compiled by its own
+ * thread and context, with its own ic and dc and its own labels, which are relative to the start of the chunk.
+ * the chunks are then merged by their order: the ic and dc of the previous chunks (a prefix sum) are added to the
+ * addresses of the labels and instructions of each chunk, and a label which is defined by 2 chunks is detected.
+ * the result is the same as compiling the whole source by a single thread. a source with errors is compiled again
+ * by a single thread, so its errors are found and reported exactly as they are without chunks.
+ */
+
+#include "parallel_stage_1.h"
+#include "arena.h"
+#include "assembler.h"
+#include "fixup_list.h"
+#include "instruction_list.h"
+#include "memory_image.h"
+#include "stage_1.h"
+#include "symbols_table.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Prototypes */
+static void *compile_chunk(void *arg);
+static long find_line(line_index *lines, long offset);
+static status merge_chunk(assembler_ctx *ctx, assembler_ctx *chunk);
+static void reset_first_pass(assembler_ctx *ctx);
+
+/**
+ * @brief compiles the lines of the source over chunks in parallel, when the source is large enough and the context
+ * has more than a single thread. the lines of the source must be split already.
+ *
+ * @param ctx the assembler context
+ * @param text the source
+ * @return SUCCESS if the source was compiled, otherwise FAILED, and the source should be compiled by a single thread.
+ */
+status stage_1_parallel(assembler_ctx *ctx, char *text) {
+    line_index *lines = &ctx->lines;
+    long num_chunks = lines->count / MIN_CHUNK_LINES;
+    source_chunk *chunks;
+    pthread_t *threads;
+    bool *started;
+    status result = SUCCESS;
+    long i;
+
+    if (num_chunks > ctx->num_threads)
+        num_chunks = ctx->num_threads;
+    if (num_chunks < 2)
+        return FAILED;
+
+    chunks = (source_chunk *)arena_alloc(&ctx->temps, sizeof(source_chunk) * num_chunks);
+    threads = (pthread_t *)arena_alloc(&ctx->temps, sizeof(pthread_t) * num_chunks);
+    started = (bool *)arena_alloc(&ctx->temps, sizeof(bool) * num_chunks);
+
+    /* chunks of about the same number of characters, which start at a line */
+    for (i = 0; i < num_chunks; i++) {
+        chunks[i].ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+        assembler_init(chunks[i].ctx);
+        chunks[i].ctx->load_base = ctx->load_base;
+        chunks[i].ctx->memory_size = ctx->memory_size;
+        chunks[i].lines = lines;
+        chunks[i].text = text;
+        chunks[i].first_line = i == 0 ? 0 : chunks[i - 1].end_line;
+        chunks[i].end_line = i == num_chunks - 1 ? lines->count : find_line(lines, (lines->items[lines->count - 1].start / num_chunks) * (i + 1));
+    }
+
+    /* the first chunk is compiled by the calling thread, and a chunk whose thread can't start is compiled by it too */
+    for (i = 1; i < num_chunks; i++)
+        started[i] = pthread_create(&threads[i], NULL, compile_chunk, &chunks[i]) == 0;
+    compile_chunk(&chunks[0]);
+    for (i = 1; i < num_chunks; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            compile_chunk(&chunks[i]);
+    }
+
+    for (i = 0; i < num_chunks && result == SUCCESS; i++)
+        result = merge_chunk(ctx, chunks[i].ctx);
+    if (result == FAILED)
+        reset_first_pass(ctx);
+
+    for (i = 0; i < num_chunks; i++) {
+        assembler_free(chunks[i].ctx);
+        free(chunks[i].ctx);
+    }
+    return result;
+}
+
+/**
+ * @brief compiles the lines of a chunk by its own context
+ *
+ * @param arg the chunk
+ * @return NULL
+ */
+static void *compile_chunk(void *arg) {
+    source_chunk *chunk = (source_chunk *)arg;
+
+    compile_lines(chunk->ctx, chunk->lines, chunk->text, chunk->first_line, chunk->end_line);
+    return NULL;
+}
+
+/**
+ * @param lines the lines of the source
+ * @param offset an offset in the source
+ * @return long index of the first line which starts at the offset or after it
+ */
+static long find_line(line_index *lines, long offset) {
+    long low = 0, high = lines->count, middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (lines->items[middle].start < offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief appends a compiled chunk to the first pass of the whole source, if it doesn't depend on the previous chunks.
+ *
+ * @param ctx the assembler context of the whole source
+ * @param chunk the context of the chunk
+ * @return SUCCESS, or FAILED if the chunk has errors, or depends on the labels of the previous chunks.
+ */
+static status merge_chunk(assembler_ctx *ctx, assembler_ctx *chunk) {
+    if (chunk->error_occured_flag || chunk->unchecked_label)
+        return FAILED;
+    if (ctx->memory_size > 0 && ctx->load_base + ctx->ic + chunk->ic + ctx->dc + chunk->dc > (unsigned int)ctx->memory_size)
+        return FAILED; /* the error is reported by a single thread */
+
+    return append_first_pass(ctx, chunk, 0);
+}
+
+/**
+ * @brief appends the first pass of a range of lines, which was compiled by its own context, to the first pass of
+ * the whole source: its labels, its instructions and .entry directives with the ids of their labels in the whole
+ * source, its data, and its errors.
+ *
+ * @param ctx the assembler context of the whole source
+ * @param chunk the context of the range of lines
+ * @param line_shift added to the line numbers of the range, when its lines moved since it was compiled
+ * @return SUCCESS, or FAILED if a label of the range was already defined by the previous ranges.
+ */
+status append_first_pass(assembler_ctx *ctx, assembler_ctx *chunk, int line_shift) {
+    int *id_map;
+    instruction *instr;
+    fixup *entry;
+    diagnostic *item;
+    int i;
+
+    id_map = (int *)arena_alloc(&ctx->temps, sizeof(int) * (chunk->symbols_tbl.count + 1));
+    if (!merge_labels(&ctx->symbols_tbl, &chunk->symbols_tbl, id_map, ctx->ic, ctx->dc))
+        return FAILED; /* a label which is defined by 2 chunks */
+
+    for (i = 0; i < chunk->instructions.count; i++) {
+        instr = add_instruction(&ctx->instructions);
+        *instr = chunk->instructions.items[i];
+        instr->address += ctx->ic;
+        instr->line_num += line_shift;
+        if (instr->src.label_id != NOT_FOUND)
+            instr->src.label_id = id_map[instr->src.label_id];
+        if (instr->dest.label_id != NOT_FOUND)
+            instr->dest.label_id = id_map[instr->dest.label_id];
+    }
+
+    for (i = 0; i < chunk->fixups.count; i++) {
+        entry = &chunk->fixups.items[i];
+        add_fixup(&ctx->fixups, entry->label_id != NOT_FOUND ? id_map[entry->label_id] : NOT_FOUND, entry->line_num + line_shift);
+    }
+
+    if (chunk->dc > 0) {
+        image_reserve(&ctx->data_memory, ctx->dc + chunk->dc);
+        memcpy(ctx->data_memory.words + ctx->dc, chunk->data_memory.words, sizeof(machine_word) * chunk->dc);
+    }
+    ctx->ic += chunk->ic;
+    ctx->dc += chunk->dc;
+    if (chunk->extern_exists)
+        ctx->extern_exists = TRUE;
+
+    /* the errors of the range follow the errors of the previous ranges, by order of lines */
+    for (i = 0; i < chunk->diagnostics.count; i++) {
+        if (ctx->diagnostics.count == MAX_DIAGNOSTICS) {
+            ctx->diagnostics.dropped++;
+            continue;
+        }
+        item = &ctx->diagnostics.items[ctx->diagnostics.count++];
+        *item = chunk->diagnostics.items[i];
+        item->line_num += line_shift;
+    }
+    ctx->diagnostics.dropped += chunk->diagnostics.dropped;
+    if (chunk->error_occured_flag)
+        ctx->error_occured_flag = TRUE;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief clears the chunks which were merged, so the source can be compiled again by a single thread
+ *
+ * @param ctx the assembler context of the whole source
+ */
+static void reset_first_pass(assembler_ctx *ctx) {
+    symbols_reset(&ctx->symbols_tbl);
+    ctx->instructions.count = 0;
+    ctx->fixups.count = 0;
+    ctx->ic = ctx->dc = 0;
+    ctx->extern_exists = FALSE;
+}
@@ -0,0 +1,23 @@
+#ifndef PARALLEL_STAGE_1_H
+#define PARALLEL_STAGE_1_H
+
+#include "global.h"
+#include <pthread.h>
+
+/* Declarations */
+#define MIN_CHUNK_LINES 16384 /* a source is split to chunks of at least this number of lines */
+
+/* a chunk of the source, which is compiled by the first pass separately from the other chunks */
+typedef struct {
+    assembler_ctx *ctx; /* the context of the chunk: its labels, instructions, memory images, ic and dc */
+    line_index *lines;  /* the lines of the whole source, which are shared by the chunks */
+    char *text;         /* the source */
+    long first_line;    /* index of the first line of the chunk */
+    long end_line;      /* index of the line after the last line of the chunk */
+} source_chunk;
+
+/* Prototypes */
+status stage_1_parallel(assembler_ctx *ctx, char *text);
+status append_first_pass(assembler_ctx *ctx, assembler_ctx *chunk, int line_shift);
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file parallel_stage_2.c
+ * @brief this file includes the encoding of the instructions in parallel, when the symbols table is complete.
+ * the symbols table doesn't change after stage 1, so every instruction can be encoded independently of the others:
+ * the instructions are split to slices, and each slice is encoded by its own thread, to its own range of the
+ * instructions memory, and with its own list of references to external labels. the first slice lists its references
+ * in the list of the context, and the lists of the other slices are appended to it by the order of the slices, which
+ * is the order of the addresses, so the .ext file is the same for any number of threads.
+ */
+
+#include "parallel_stage_2.h"
+#include "arena.h"
+#include "extern_refs.h"
+#include "memory_image.h"
+#include "stage_2.h"
+#include "utils.h"
+#include <stdlib.h>
+
+/* Prototypes */
+static void *encode_slice(void *arg);
+
+/**
+ * @brief encodes all the instructions to the instructions memory, and lists the references to external labels.
+ * a context with more than a single thread splits a large number of instructions to slices, which are encoded
+ * in parallel.
+ *
+ * @param ctx the assembler context
+ * @return int the number of operands whose label isn't defined (their words are left empty)
+ */
+int encode_instructions(assembler_ctx *ctx) {
+    int num_instructions = ctx->instructions.count;
+    int num_slices = num_instructions / MIN_SLICE_INSTRUCTIONS;
+    instruction_slice *slices;
+    pthread_t *threads;
+    bool *started;
+    int i, num_unresolved = 0;
+
+    if (num_slices > ctx->num_threads)
+        num_slices = ctx->num_threads;
+    if (num_slices < 1)
+        num_slices = 1;
+
+    image_reserve(&ctx->instr_memory, ctx->ic);
+    slices = (instruction_slice *)arena_alloc(&ctx->temps, sizeof(instruction_slice) * num_slices);
+    threads = (pthread_t *)arena_alloc(&ctx->temps, sizeof(pthread_t) * num_slices);
+    started = (bool *)arena_alloc(&ctx->temps, sizeof(bool) * num_slices);
+
+    /* slices of the same number of instructions */
+    for (i = 0; i < num_slices; i++) {
+        slices[i].symbols_tbl = &ctx->symbols_tbl;
+        slices[i].memory = ctx->instr_memory.words;
+        slices[i].first = ctx->instructions.items + (long)num_instructions * i / num_slices;
+        slices[i].end = ctx->instructions.items + (long)num_instructions * (i + 1) / num_slices;
+        slices[i].num_unresolved = 0;
+        if (i > 0)
+            extern_refs_init(&slices[i].externs);
+    }
+    ctx->externs.count = 0;
+    slices[0].externs = ctx->externs;
+
+    /* the first slice is encoded by the calling thread, and a slice whose thread can't start is encoded by it too */
+    for (i = 1; i < num_slices; i++)
+        started[i] = pthread_create(&threads[i], NULL, encode_slice, &slices[i]) == 0;
+    encode_slice(&slices[0]);
+    for (i = 1; i < num_slices; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            encode_slice(&slices[i]);
+    }
+
+    /* the references of the slices, by order of their addresses */
+    ctx->externs = slices[0].externs; /* the list may have grown */
+    num_unresolved = slices[0].num_unresolved;
+    for (i = 1; i < num_slices; i++) {
+        append_extern_refs(&ctx->externs, &slices[i].externs);
+        num_unresolved += slices[i].num_unresolved;
+        extern_refs_free(&slices[i].externs);
+    }
+
+    return num_unresolved;
+}
+
+/**
+ * @brief encodes the instructions of a slice
+ *
+ * @param arg the slice
+ * @return NULL
+ */
+static void *encode_slice(void *arg) {
+    instruction_slice *slice = (instruction_slice *)arg;
+    instruction *instr;
+
+    for (instr = slice->first; instr < slice->end; instr++)
+        encode_instruction(slice, instr);
+    return NULL;
+}
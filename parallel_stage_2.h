@@ -0,0 +1,13 @@
+#ifndef PARALLEL_STAGE_2_H
+#define PARALLEL_STAGE_2_H
+
+#include "global.h"
+#include <pthread.h>
+
+/* Declarations */
+#define MIN_SLICE_INSTRUCTIONS 8192 /* the instructions are split to slices of at least this number of instructions */
+
+/* Prototypes */
+int encode_instructions(assembler_ctx *ctx);
+
+#endif
@@ -5,86 +5,136 @@
 
 #include "pre_processor.h"
 #include "global.h"
+#include "lexer.h"
+#include "string_pool.h"
 #include "text_engine.h"
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-/* global variables */
-bool reading_macro;
-macro_ptr curr_macro;
-macro_ptr macro_pointer;
-FILE *macro_file;
-
 /**
  * @brief function which manages all the pre-processor actions, expanding macros.
+ * the expanded source is kept in memory for stage 1.
  *
- * @param curr_file the current filename to process
- * @param filename the filename if the given file
+ * @param ctx the assembler context
+ * @param source the source code to process
+ * @param length length of the source code
+ * @param expanded an empty buffer to hold the expanded source
  */
-void pre_processor(FILE *curr_file, char *filename) {
-    /*char* input_filename;*/
-    char temp_line[MAX_LINE_LENGTH]; /* temporary string for storing line, read from file */
-    int line_count = 1;
-
-    printf("\n\n __________________________\n");
-    printf("|       Pre-processor      |\n");
-    printf(" ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
-
-    reading_macro = FALSE;
-    macro_file = create_file(filename, FILE_MACRO);
-    /*input_filename = str_alloc_concat(filename,".am");
-    macro_file = fopen(input_filename, "w");*/
-
-    curr_macro = NULL;
-
-    /* Read lines until end of file */
-    printf("* Expanding macros(if exists).\n");
-    while (fgets(temp_line, MAX_LINE_LENGTH, curr_file) != NULL) {
-        read_line_pp(temp_line, line_count);
-        line_count++; /* increment line counter */
-    }
+void pre_processor(assembler_ctx *ctx, const char *source, long length, text_buffer *expanded) {
+    long i;
+
+    print_log(ctx, "\n\n __________________________\n");
+    print_log(ctx, "|       Pre-processor      |\n");
+    print_log(ctx, " ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
 
-    freelist(&curr_macro);
-    fclose(macro_file);
-    /*free(input_filename);*/
+    ctx->reading_macro = FALSE;
+    ctx->expanded_source = expanded;
+    macros_reset(&ctx->macros);
+    ctx->curr_macro = NULL;
 
-    printf("* Pre assembler finsihed.");
+    /* Read lines until end of file, straight from the source */
+    print_log(ctx, "* Expanding macros(if exists).\n");
+    split_lines(&ctx->lines, source, length);
+    for (i = 0; i < ctx->lines.count; i++)
+        read_line_pp(ctx, (char *)source, i);
+
+    print_log(ctx, "* Pre assembler finsihed.");
 }
 
 /**
- * @brief function which reads a given line and interpret it
- *
- * @param line the line to interpret
- * @param line_num the number of the given line
+ * @param word a word, which is a span of a line
+ * @param length the length of the word
+ * @param keyword a null terminated keyword
+ * @return true if the word is the given keyword
  */
-void read_line_pp(char *line, int line_num) {
+static bool is_word(char *word, int length, char *keyword) {
+    return length == (int)strlen(keyword) && !strncmp(word, keyword, length);
+}
 
-    char word[MAX_LINE_LENGTH];
-    char *all_line = line;
+/**
+ * @brief finds the first word of a line which was tokenized, after a label if the line starts with one
+ *
+ * @param ctx the assembler context
+ * @param word set to the word (a label alone in the line is the word, without its colon)
+ * @param word_length set to the length of the word
+ * @return int the index of the token after the word in the tokens of the line
+ */
+static int line_command(assembler_ctx *ctx, char **word, int *word_length) {
+    token_list *tokens = &ctx->tokens;
+    int first = 0, end;
 
-    line = skip_spaces(line);
-    copy_word(word, line);
+    *word = "";
+    *word_length = 0;
+    end = word_end(tokens, first);
+    if (end > first) {
+        *word = TOKEN_TEXT(tokens, first);
+        *word_length = TOKENS_LENGTH(tokens, first, end);
+    }
 
     /* if first word is label, check the next one */
-    if (is_label(word, TRUE)) {
+    if (is_label(ctx, *word, *word_length, TRUE)) {
+        (*word_length)--; /* a label alone in the line is checked without its colon */
         /* check next word for macro */
-        line = next_word(line);
-        copy_word(word, line);
+        first = end;
+        end = word_end(tokens, first);
+        if (end > first) {
+            *word = TOKEN_TEXT(tokens, first);
+            *word_length = TOKENS_LENGTH(tokens, first, end);
+        }
     }
-    if (reading_macro) { /* if it's macro we will just add the lines to the macro table until endmacro */
+    return end;
+}
+
+/**
+ * @brief checks if a line starts the definition of a macro, exactly as the pre-processor reads it
+ *
+ * @param ctx the assembler context
+ * @param lines the lines of the source
+ * @param source the source
+ * @param index the index of the line
+ * @return true if the first word of the line (after a label) is "macro"
+ */
+bool is_macro_definition(assembler_ctx *ctx, line_index *lines, char *source, long index) {
+    char *word;
+    int word_length;
+
+    tokenize_line(&ctx->tokens, lines, source, index);
+    line_command(ctx, &word, &word_length);
+    return is_word(word, word_length, "macro");
+}
+
+/**
+ * @brief function which reads a given line of the source and interpret it
+ *
+ * @param ctx the assembler context
+ * @param source the source, which was split to lines
+ * @param index the index of the line to interpret
+ */
+void read_line_pp(assembler_ctx *ctx, char *source, long index) {
+    char *line = source + ctx->lines.items[index].start; /* not null terminated */
+    long length = ctx->lines.items[index].length;        /* incl. the new line character */
+    char *word; /* the first word of the line (after a label) */
+    int word_length, end;
+
+    tokenize_line(&ctx->tokens, &ctx->lines, source, index);
+    end = line_command(ctx, &word, &word_length);
+    if (ctx->reading_macro) { /* if it's macro we will just add the lines to the macro table until endmacro */
         /* finish macro reading */
-        if (!strcmp(word, "endmacro")) {
-            reading_macro = FALSE;
+        if (is_word(word, word_length, "endmacro")) {
+            ctx->reading_macro = FALSE;
             return;
         }
-        /* add line to macro content */
-        strcat(curr_macro->content, all_line);
+        /* add line to macro content, which is always the last span in the arena */
+        if (ctx->curr_macro != NULL) {
+            text_buffer_append(&ctx->macros.arena, line, length);
+            ctx->curr_macro->content_length += length;
+        }
     } else { /* Check for start of macro */
-        macro_handler(word, line);
-        if (!reading_macro) {
-            add_line(all_line, word);
+        macro_handler(ctx, word, word_length, end);
+        if (!ctx->reading_macro) {
+            add_line(ctx, line, length, word, word_length);
         }
     }
 }
@@ -92,120 +142,163 @@ void read_line_pp(char *line, int line_num) {
 /**
  * @brief function which gets the current word and it's line, and add it to the macro list
  *
+ * @param ctx the assembler context
  * @param word current word to check
- * @param line the current line to check
+ * @param word_length the length of the word
+ * @param next index of the token after the word in the tokens of the line
  */
-void macro_handler(char *word, char *line) {
-    if (!strcmp(word, "macro")) { /* enter if macro */
-        reading_macro = TRUE;
+void macro_handler(assembler_ctx *ctx, char *word, int word_length, int next) {
+    token_list *tokens = &ctx->tokens;
+    int end;
+
+    if (is_word(word, word_length, "macro")) { /* enter if macro */
+        ctx->reading_macro = TRUE;
 
         /* get the name of the macro and insert to Macro list */
-        line = next_word(line);
-        copy_word(word, line);
+        end = word_end(tokens, next);
+        if (end > next) {
+            word = TOKEN_TEXT(tokens, next);
+            word_length = TOKENS_LENGTH(tokens, next, end);
+        }
 
-        add_macro(&curr_macro, word);
+        add_macro(ctx, word, word_length);
     }
 }
 
 /**
  * @brief check if a given macro name is valid (check if reserved word)
  *
+ * @param ctx the assembler context
  * @param mac_name macro name
+ * @param name_length length of the name
  * @return TRUE, if macro is *VALID*
  * @return FALSE, if macro is *INVALID*
  */
-status macro_validation(char *mac_name) {
-    if (is_macro_exist(curr_macro, mac_name))
+status macro_validation(assembler_ctx *ctx, char *mac_name, long name_length) {
+    if (is_macro_exist(&ctx->macros, mac_name, name_length))
         return INVALID;
 
     /* check if macro is command name */
-    if (is_reserved_word(mac_name))
+    if (is_reserved_word(mac_name, name_length))
         return INVALID;
 
     return VALID;
 }
 
 /**
- * @brief function which gets a macro name and adds it to the macro table
+ * @brief function which gets a macro name and adds it to the macro table.
+ * the new macro becomes the current macro, which the following lines are added to.
+ * an invalid name is ignored, so the lines are added to the previous macro.
  *
- * @param macroTable the macro table to insert to it
+ * @param ctx the assembler context
  * @param macroName the name of the macro
+ * @param name_length length of the name
  */
-void add_macro(macro_ptr *macroTable, char *macroName) {
-    macro_ptr ptr1, ptr2;
-    if (macro_validation(macroName)) {
-        ptr1 = (macro_ptr)malloc_w_check(sizeof(macro_list));
-
-        /* Save the new macro as a node in our table */
-        strcpy(ptr1->name, macroName);
-        if (*macroTable == NULL) /* Init Macro list: if table empty */
-            *macroTable = ptr1;
-        else { /* Add macro to existing list: add the new macro as the last node in table */
-            ptr2 = *macroTable;
-            *macroTable = ptr1;
-            ptr1->next = ptr2;
+void add_macro(assembler_ctx *ctx, char *macroName, long name_length) {
+    macro_table *macroTable = &ctx->macros; /* the macro table to insert to it */
+    macro_ptr ptr1;
+
+    if (macro_validation(ctx, macroName, name_length)) {
+        if (macroTable->count == macroTable->capacity) {
+            macroTable->capacity *= 2;
+            macroTable->macros = (macro_list *)realloc_w_check(macroTable->macros, sizeof(macro_list) * macroTable->capacity);
         }
+
+        /* Save the new macro in our table, its name is interned in the pool of names */
+        ptr1 = &macroTable->macros[macroTable->count];
+        ptr1->name_id = intern_string(macroTable->names, macroName, name_length);
+        ptr1->content_offset = macroTable->arena.length;
+        ptr1->content_length = 0;
+
+        name_map_set(&macroTable->macro_ids, ptr1->name_id, macroTable->count++);
+        ctx->curr_macro = ptr1;
     }
 }
 
 /**
- * @brief insert a given line to the macro file, or expand macros if it's a macro callback.
+ * @brief insert a given line to the expanded source, or expand macros if it's a macro callback.
  *
+ * @param ctx the assembler context
  * @param line the current line
+ * @param length the length of the line
  * @param word the current word in the given line
+ * @param word_length the length of the word
  */
-void add_line(char *line, char *word) {
+void add_line(assembler_ctx *ctx, char *line, long length, char *word, long word_length) {
+    macro_ptr macro_pointer;
+
     /* add line depend if it's macro name or regular code */
-    if ((macro_pointer = check_macro(curr_macro, word)) != NULL) {
+    if ((macro_pointer = check_macro(&ctx->macros, word, word_length)) != NULL) {
         /* Expand macro content */
-        fputs(macro_pointer->content, macro_file);
+        text_buffer_append(ctx->expanded_source, ctx->macros.arena.data + macro_pointer->content_offset, macro_pointer->content_length);
     } else {
         /* place the code as is! */
-        fputs(line, macro_file);
+        text_buffer_append(ctx->expanded_source, line, length);
     }
 }
 
 /**
- * @brief checks if there is existing macro in the list that match to the macro name .
+ * @brief checks if there is existing macro in the table that match to the macro name .
  *
- * @param macroTable macro list to search
+ * @param macroTable macro table to search
  * @param word macro name
+ * @param name_length length of the name
  * @return macro_ptr return a pointer to the existing macro. NULL if doesn't exist.
  */
-macro_ptr check_macro(macro_ptr macroTable, char *word) {
-    macro_ptr ptr1;
-    ptr1 = macroTable;
+macro_ptr check_macro(macro_table *macroTable, char *word, long name_length) {
+    int index = name_map_get(&macroTable->macro_ids, find_string(macroTable->names, word, name_length));
 
-    while (ptr1 != NULL) {
-        if (!strcmp(ptr1->name, word))
-            return ptr1;
-        ptr1 = ptr1->next;
-    }
-    return NULL;
+    return index == NOT_FOUND ? NULL : &macroTable->macros[index];
 }
 
 /**
- * @brief checks if there is existing macro in the list that match to the macro name .
+ * @brief checks if there is existing macro in the table that match to the macro name .
  *
- * @param macroTable macro list to search
- * @param word macro name
- * @return macro_ptr return a pointer to the existing macro. NULL if doesn't exist.
+ * @param macroTable macro table to search
+ * @param mac_name macro name
+ * @param name_length length of the name
+ * @return true if the macro exists, otherwise false.
  */
-bool is_macro_exist(macro_ptr macroTable, char *mac_name) {
-    return check_macro(macroTable, mac_name) == NULL ? FALSE : TRUE;
+bool is_macro_exist(macro_table *macroTable, char *mac_name, long name_length) {
+    return check_macro(macroTable, mac_name, name_length) == NULL ? FALSE : TRUE;
 }
 
 /**
- * @brief free the memory which was allocated to the macros list
+ * @brief initialize an empty macro table
  *
- * @param macroTable the macro list to free
+ * @param macroTable the macro table to initialize
+ * @param names the pool which the names of the macros are interned in
  */
-void freelist(macro_ptr *macroTable) {
+void macros_init(macro_table *macroTable, string_pool *names) {
+    macroTable->count = 0;
+    macroTable->capacity = MACROS_INIT_CAPACITY;
+    macroTable->macros = (macro_list *)malloc_w_check(sizeof(macro_list) * macroTable->capacity);
+    macroTable->names = names;
+    name_map_init(&macroTable->macro_ids);
+    text_buffer_init(&macroTable->arena);
+}
 
-    macro_ptr p;
-    while (*macroTable) {
-        p = *macroTable;
-        *macroTable = (*macroTable)->next;
-        free(p);
-    }
+/**
+ * @brief removes all the macros from the table, and keeps its memory for the next source
+ *
+ * @param macroTable the macro table to clear
+ */
+void macros_reset(macro_table *macroTable) {
+    macroTable->count = 0;
+    name_map_reset(&macroTable->macro_ids);
+    macroTable->arena.length = 0;
+    macroTable->arena.data[0] = '\0';
+}
+
+/**
+ * @brief free the memory which was allocated to the macro table
+ *
+ * @param macroTable the macro table to free
+ */
+void freelist(macro_table *macroTable) {
+    free(macroTable->macros);
+    name_map_free(&macroTable->macro_ids);
+    text_buffer_free(&macroTable->arena);
+    macroTable->macros = NULL;
+    macroTable->count = macroTable->capacity = 0;
 }
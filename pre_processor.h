@@ -3,26 +3,22 @@
 
 #include "global.h"
 #include <stdio.h>
-#define MACRO_NAME_LEN 35 /* *Assumption*: Max length of macro name */
-#define MACRO_ROWS 15     /* *Assumption*: Max macro content rows */
 
 /* Declarations */
-typedef struct Macro *macro_ptr;
-typedef struct Macro {
-    char name[MACRO_NAME_LEN];                  /* macro unique name */
-    char content[MAX_LINE_LENGTH * MACRO_ROWS]; /* content of the macro to expand */
-    macro_ptr next;                             /* pointer to the next macro */
-} macro_list;
+#define MACROS_INIT_CAPACITY 16 /* initial length of the macros array */
 
 /* Prototypes */
-void pre_processor(FILE *, char *);
-void read_line_pp(char *, int);
-void add_line(char *, char *);
-void macro_handler(char *, char *);
-void add_macro(macro_ptr *, char *);
-status macro_validation(char *mac_name);
-macro_ptr check_macro(macro_ptr, char *);
-bool is_macro_exist(macro_ptr, char *);
-void freelist(macro_ptr *);
+void pre_processor(assembler_ctx *ctx, const char *source, long length, text_buffer *expanded);
+void read_line_pp(assembler_ctx *ctx, char *source, long index);
+bool is_macro_definition(assembler_ctx *ctx, line_index *lines, char *source, long index);
+void add_line(assembler_ctx *ctx, char *line, long length, char *word, long word_length);
+void macro_handler(assembler_ctx *ctx, char *word, int word_length, int next);
+void add_macro(assembler_ctx *ctx, char *macroName, long name_length);
+status macro_validation(assembler_ctx *ctx, char *mac_name, long name_length);
+macro_ptr check_macro(macro_table *, char *word, long name_length);
+bool is_macro_exist(macro_table *, char *mac_name, long name_length);
+void macros_init(macro_table *, string_pool *names);
+void macros_reset(macro_table *);
+void freelist(macro_table *);
 
 #endif
@@ -0,0 +1,314 @@
+/**
+ * @file scanner.c
+ * @brief this file includes the scanner of the assembler, which splits a text to lines in a single pass.
+ * the text is scanned in blocks of 64 characters (the bits of a bitmap word), and the new lines, the whitespaces
+ * and the separators (whitespaces and commas) of a block are found together, as a bitmap word each.
+ * the new lines of a block become the line spans, and the whitespace and separator bitmaps are kept for the lexer,
+ * which skips a run of whitespaces, or finds the end of a token, by looking for the next clear or set bit instead
+ * of checking the characters one by one. so the bits of a line are the bits from the offset of the line.
+ * the blocks are scanned with AVX2 or SSE2 instructions on x86-64 processors, or with a loop over the characters
+ * on any other machine. the kernel is chosen at runtime, by the features of the processor.
+ */
+
+#include "scanner.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__LP64__)
+#define SCAN_SIMD /* a bitmap word is 64 bits, and the SSE2 and AVX2 kernels are built */
+#include <immintrin.h>
+#endif
+
+/* the bitmap words of a block of text */
+typedef struct {
+    unsigned long newlines;
+    unsigned long spaces;
+    unsigned long separators;
+} block_bits;
+
+/* a kernel, which scans a block of BITS_PER_WORD characters */
+typedef void (*block_scanner)(const char *block, block_bits *bits);
+
+static const char *kernel_names[] = {"scalar", "sse2", "avx2"};
+
+/**
+ * @brief scans a block a character at a time.
+ * the whitespaces are the characters of isspace() in the "C" locale: ' ', '\t', '\n', '\v', '\f' and '\r'.
+ *
+ * @param block the characters to scan
+ * @param bits the bitmap words of the block
+ */
+static void scan_block_scalar(const char *block, block_bits *bits) {
+    unsigned long bit = 1;
+    unsigned char c;
+    long i;
+
+    bits->newlines = bits->spaces = bits->separators = 0;
+    for (i = 0; i < BITS_PER_WORD; i++, bit <<= 1) {
+        c = (unsigned char)block[i];
+        if (c == '\n')
+            bits->newlines |= bit;
+        if (c == ' ' || (c >= '\t' && c <= '\r')) {
+            bits->spaces |= bit;
+            bits->separators |= bit;
+        } else if (c == ',')
+            bits->separators |= bit;
+    }
+}
+
+#ifdef SCAN_SIMD
+/**
+ * @brief scans a block 16 characters at a time, with SSE2 instructions (which every x86-64 processor has)
+ *
+ * @param block the characters to scan
+ * @param bits the bitmap words of the block
+ */
+static void scan_block_sse2(const char *block, block_bits *bits) {
+    const __m128i newline = _mm_set1_epi8('\n'), space = _mm_set1_epi8(' '), comma = _mm_set1_epi8(',');
+    const __m128i before_tab = _mm_set1_epi8('\t' - 1), after_cr = _mm_set1_epi8('\r' + 1);
+    __m128i chars, is_space;
+    int i;
+
+    bits->newlines = bits->spaces = bits->separators = 0;
+    for (i = 0; i < 4; i++) {
+        chars = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+        /* '\t' to '\r' is a range of whitespaces (the comparison is signed, so characters above 127 are out of it) */
+        is_space = _mm_or_si128(_mm_cmpeq_epi8(chars, space),
+                                _mm_and_si128(_mm_cmpgt_epi8(chars, before_tab), _mm_cmpgt_epi8(after_cr, chars)));
+
+        bits->newlines |= (unsigned long)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chars, newline)) << (16 * i);
+        bits->spaces |= (unsigned long)(unsigned int)_mm_movemask_epi8(is_space) << (16 * i);
+        bits->separators |= (unsigned long)(unsigned int)_mm_movemask_epi8(_mm_or_si128(is_space, _mm_cmpeq_epi8(chars, comma)))
+                            << (16 * i);
+    }
+}
+
+/**
+ * @brief scans a block 32 characters at a time, with AVX2 instructions.
+ * it's built for AVX2 regardless of the compiler flags, and used only if the processor supports it.
+ *
+ * @param block the characters to scan
+ * @param bits the bitmap words of the block
+ */
+__attribute__((target("avx2"))) static void scan_block_avx2(const char *block, block_bits *bits) {
+    const __m256i newline = _mm256_set1_epi8('\n'), space = _mm256_set1_epi8(' '), comma = _mm256_set1_epi8(',');
+    const __m256i before_tab = _mm256_set1_epi8('\t' - 1), after_cr = _mm256_set1_epi8('\r' + 1);
+    __m256i chars, is_space;
+    int i;
+
+    bits->newlines = bits->spaces = bits->separators = 0;
+    for (i = 0; i < 2; i++) {
+        chars = _mm256_loadu_si256((const __m256i *)(block + 32 * i));
+        is_space = _mm256_or_si256(_mm256_cmpeq_epi8(chars, space),
+                                   _mm256_and_si256(_mm256_cmpgt_epi8(chars, before_tab), _mm256_cmpgt_epi8(after_cr, chars)));
+
+        bits->newlines |= (unsigned long)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, newline)) << (32 * i);
+        bits->spaces |= (unsigned long)(unsigned int)_mm256_movemask_epi8(is_space) << (32 * i);
+        bits->separators |= (unsigned long)(unsigned int)_mm256_movemask_epi8(_mm256_or_si256(is_space, _mm256_cmpeq_epi8(chars, comma)))
+                            << (32 * i);
+    }
+}
+#endif
+
+/**
+ * @param kernel a scanning kernel (enum scan_kernels)
+ * @return block_scanner the function of the kernel
+ */
+static block_scanner get_block_scanner(int kernel) {
+#ifdef SCAN_SIMD
+    if (kernel == SCAN_AVX2)
+        return scan_block_avx2;
+    if (kernel == SCAN_SSE2)
+        return scan_block_sse2;
+#endif
+    return scan_block_scalar;
+}
+
+/**
+ * @param word a bitmap word which isn't 0
+ * @return int the index of the lowest set bit of the word
+ */
+static int lowest_set_bit(unsigned long word) {
+#ifdef __GNUC__
+    return __builtin_ctzl(word);
+#else
+    int i = 0;
+
+    for (; !(word & 1UL); word >>= 1)
+        i++;
+    return i;
+#endif
+}
+
+/**
+ * @brief initialize an empty line index, with the fastest kernel that the processor supports
+ *
+ * @param lines the index to initialize
+ */
+void lines_init(line_index *lines) {
+    lines->count = 0;
+    lines->capacity = LINES_INIT_CAPACITY;
+    lines->items = (line_span *)malloc_w_check(sizeof(line_span) * lines->capacity);
+    lines->bitmap_capacity = BITMAP_INIT_CAPACITY;
+    lines->spaces = (unsigned long *)malloc_w_check(sizeof(unsigned long) * lines->bitmap_capacity);
+    lines->separators = (unsigned long *)malloc_w_check(sizeof(unsigned long) * lines->bitmap_capacity);
+
+    lines->kernel = SCAN_SCALAR;
+    if (!set_scan_kernel(lines, SCAN_AVX2))
+        set_scan_kernel(lines, SCAN_SSE2);
+}
+
+/**
+ * @brief free memory allocation of a given line index
+ *
+ * @param lines the index to free
+ */
+void lines_free(line_index *lines) {
+    free(lines->items);
+    free(lines->spaces);
+    free(lines->separators);
+    lines->items = NULL;
+    lines->spaces = lines->separators = NULL;
+    lines->count = lines->capacity = lines->bitmap_capacity = 0;
+}
+
+/**
+ * @param kernel a scanning kernel (enum scan_kernels)
+ * @return true if the kernel is built, and the processor supports it
+ */
+bool scan_kernel_supported(int kernel) {
+    switch (kernel) {
+    case SCAN_SCALAR:
+        return TRUE;
+#ifdef SCAN_SIMD
+    case SCAN_SSE2:
+        return TRUE;
+    case SCAN_AVX2:
+        return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+#endif
+    default:
+        return FALSE;
+    }
+}
+
+/**
+ * @brief sets the kernel which scans the texts of a line index (every kernel gives the same result).
+ *
+ * @param lines the index
+ * @param kernel a scanning kernel (enum scan_kernels)
+ * @return true if the kernel was set, false if it isn't supported (and the kernel wasn't changed)
+ */
+bool set_scan_kernel(line_index *lines, int kernel) {
+    if (!scan_kernel_supported(kernel))
+        return FALSE;
+    lines->kernel = kernel;
+    return TRUE;
+}
+
+/**
+ * @param kernel a scanning kernel (enum scan_kernels)
+ * @return const char* the name of the kernel
+ */
+const char *scan_kernel_name(int kernel) {
+    return kernel >= SCAN_SCALAR && kernel <= SCAN_AVX2 ? kernel_names[kernel] : "unknown";
+}
+
+/**
+ * @brief splits a text to lines, and fills the whitespace and separator bitmaps of the text, replacing the
+ * previous text of the index. a line ends after a new line character, or at the end of the text, and there is
+ * no limit to its length.
+ *
+ * @param lines the index to fill
+ * @param text the text to split (not null terminated)
+ * @param length the length of the text
+ */
+void split_lines(line_index *lines, const char *text, long length) {
+    block_scanner scan_block = get_block_scanner(lines->kernel);
+    long num_blocks = (length + BITS_PER_WORD - 1) / BITS_PER_WORD;
+    long block, offset, start = 0;
+    line_span *line;
+    char last_block[sizeof(unsigned long) * CHAR_BIT];
+    block_bits bits;
+
+    if (num_blocks > lines->bitmap_capacity) {
+        lines->bitmap_capacity = num_blocks > lines->bitmap_capacity * 2 ? num_blocks : lines->bitmap_capacity * 2;
+        lines->spaces = (unsigned long *)realloc_w_check(lines->spaces, sizeof(unsigned long) * lines->bitmap_capacity);
+        lines->separators = (unsigned long *)realloc_w_check(lines->separators, sizeof(unsigned long) * lines->bitmap_capacity);
+    }
+
+    lines->count = 0;
+    for (block = 0; block < num_blocks; block++) {
+        offset = block * BITS_PER_WORD;
+        if (length - offset >= BITS_PER_WORD)
+            scan_block(text + offset, &bits);
+        else {
+            /* the last block is scanned from a copy, which is padded with null characters, to not read after the text */
+            memset(last_block, '\0', sizeof(last_block));
+            memcpy(last_block, text + offset, length - offset);
+            scan_block(last_block, &bits);
+        }
+        lines->spaces[block] = bits.spaces;
+        lines->separators[block] = bits.separators;
+
+        /* each new line ends a line, and a block has up to BITS_PER_WORD new lines (and a last line after them) */
+        if (lines->count + BITS_PER_WORD >= lines->capacity) {
+            lines->capacity *= 2;
+            lines->items = (line_span *)realloc_w_check(lines->items, sizeof(line_span) * lines->capacity);
+        }
+        for (; bits.newlines != 0; bits.newlines &= bits.newlines - 1) {
+            line = &lines->items[lines->count++];
+            line->start = start;
+            line->length = offset + lowest_set_bit(bits.newlines) + 1 - start;
+            start += line->length;
+        }
+    }
+    if (start < length) { /* the last line has no new line character */
+        line = &lines->items[lines->count++];
+        line->start = start;
+        line->length = length - start;
+    }
+}
+
+/**
+ * @brief finds the next bit of a bitmap which is equal to a given bit
+ *
+ * @param bitmap the bitmap
+ * @param from index of the first bit to check
+ * @param end index of the bit after the last bit to check
+ * @param flip 0 to find a set bit, or all the bits set to find a clear bit
+ * @return long index of the bit, or end if there is none
+ */
+static long next_bit(const unsigned long *bitmap, long from, long end, unsigned long flip) {
+    long index = from / BITS_PER_WORD;
+    unsigned long word;
+
+    if (from >= end)
+        return end;
+
+    word = (bitmap[index] ^ flip) & (~0UL << (from % BITS_PER_WORD));
+    while (word == 0) {
+        if (++index * BITS_PER_WORD >= end)
+            return end;
+        word = bitmap[index] ^ flip;
+    }
+    from = index * BITS_PER_WORD + lowest_set_bit(word);
+    return from < end ? from : end;
+}
+
+/**
+ * @param bitmap the bitmap
+ * @param from index of the first bit to check
+ * @param end index of the bit after the last bit to check
+ * @return long index of the first set bit in the range, or end if there is none
+ */
+long next_set_bit(const unsigned long *bitmap, long from, long end) {
+    return next_bit(bitmap, from, end, 0UL);
+}
+
+/**
+ * @param bitmap the bitmap
+ * @param from index of the first bit to check
+ * @param end index of the bit after the last bit to check
+ * @return long index of the first clear bit in the range, or end if there is none
+ */
+long next_clear_bit(const unsigned long *bitmap, long from, long end) {
+    return next_bit(bitmap, from, end, ~0UL);
+}
@@ -0,0 +1,30 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include "global.h"
+#include "utils.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define LINES_INIT_CAPACITY 1024  /* initial length of the lines array */
+#define BITMAP_INIT_CAPACITY 1024 /* initial number of words in each bitmap, it grows for longer texts */
+
+/* number of bits in a bitmap word, which is also the number of characters that are scanned together */
+#define BITS_PER_WORD ((long)(sizeof(unsigned long) * CHAR_BIT))
+
+/* checks if bit i of a bitmap is set */
+#define BIT_IS_SET(bitmap, i) (((bitmap)[(i) / BITS_PER_WORD] >> ((i) % BITS_PER_WORD)) & 1UL)
+
+/* Prototypes */
+void lines_init(line_index *lines);
+void lines_free(line_index *lines);
+bool scan_kernel_supported(int kernel);
+bool set_scan_kernel(line_index *lines, int kernel);
+const char *scan_kernel_name(int kernel);
+void split_lines(line_index *lines, const char *text, long length);
+long next_set_bit(const unsigned long *bitmap, long from, long end);
+long next_clear_bit(const unsigned long *bitmap, long from, long end);
+
+#endif
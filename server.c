@@ -0,0 +1,498 @@
+/**
+ * @file server.c
+ * @brief this file includes the assembler server, which assembles sources for clients over a unix socket, and the
+ * client side of it. the server keeps a pool of workers, each with its own context, which live as long as the
+ * server, so a request doesn't pay for starting the process and warming up the memory of a context.
+ *
+ * a connection holds a single request, which is a line of a header and a payload:
+ *     ASSEMBLE SOURCE <load base> <memory size> <length>\n<the content of the source>
+ * and the reply of an assembled source is a header, a line per error, and the content of the result:
+ *     RESULT <flags> <number of errors> <length of the log> <.am length> <.ob length> <.ent length> <.ext length>\n
+ *     <line> <column> <error key>\n ...
+ *     <the log><the .am file><the .ob file><the .ent file><the .ext file>
+ * an invalid request is replied with "ERROR <message>\n". a connection which is idle for SERVER_TIMEOUT_SECONDS is
+ * dropped, so a client can't hold a worker for longer than that.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* S_ISSOCK and SO_RCVTIMEO */
+
+#include "server.h"
+#include "assembler.h"
+#include "batch.h"
+#include "utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Declarations */
+#define NUM_RESULT_SECTIONS 5 /* log, .am, .ob, .ent and .ext */
+#define RESULT_HAS_OUTPUT 1
+#define RESULT_HAS_ENTRIES 2
+#define RESULT_HAS_EXTERNALS 4
+
+/* Prototypes */
+static void *serve_worker(void *arg);
+static void serve_connection(assembler_ctx *ctx, int fd, text_buffer *request);
+static void send_result(int fd, assembly_result *result);
+static void send_error(int fd, char *message);
+static bool read_result(connection *conn, assembly_result *result);
+static int connect_socket(char *socket_path, bool listening);
+static status remove_stale_socket(struct sockaddr_un *address);
+static void set_timeout(int fd);
+static status read_header(connection *conn, char *header);
+static status read_all(connection *conn, char *data, long length);
+static status write_all(int fd, const char *data, long length);
+static void result_sections(assembly_result *result, text_buffer **sections);
+
+/**
+ * @brief runs an assembler server on a unix socket, until the process is stopped.
+ * a socket which was left by a previous server at the same path is replaced, unless that server is still running.
+ *
+ * @param socket_path the path of the socket
+ * @param num_workers number of requests which are assembled at the same time
+ * @return FAILED if the server can't start (it doesn't return otherwise)
+ */
+status run_server(char *socket_path, int num_workers) {
+    server srv;
+    pthread_t *threads;
+    int i;
+
+    /* a client which leaves before its reply must not stop the server */
+    signal(SIGPIPE, SIG_IGN);
+
+    srv.socket_path = socket_path;
+    srv.listen_fd = connect_socket(socket_path, TRUE);
+    if (srv.listen_fd < 0)
+        return FAILED;
+    printf("\nServing on %s\n", socket_path);
+    fflush(stdout);
+
+    threads = (pthread_t *)malloc_w_check(sizeof(pthread_t) * num_workers);
+    for (i = 0; i < num_workers; i++) {
+        if (pthread_create(&threads[i], NULL, serve_worker, &srv) != 0) {
+            printf("Error: Fatal: Failed to start a worker.");
+            exit(1);
+        }
+    }
+    for (i = 0; i < num_workers; i++)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    close(srv.listen_fd);
+    unlink(socket_path);
+    return FAILED;
+}
+
+/**
+ * @brief assembles a source by an assembler server
+ *
+ * @param socket_path the path of the socket of the server
+ * @param src the content of the source
+ * @param length the number of characters in the source
+ * @param load_base the address of the first instruction
+ * @param memory_size the number of addresses which the program must fit in, 0 for any
+ * @param result the result to fill, must be freed with assembly_result_free if the source was assembled
+ * @return SUCCESS if the server assembled the source, FAILED if it can't be reached or the request failed.
+ */
+status remote_assemble(char *socket_path, const char *src, long length, unsigned int load_base, int memory_size,
+                       assembly_result *result) {
+    char header[MAX_HEADER_LENGTH];
+    connection conn;
+    bool replied;
+
+    signal(SIGPIPE, SIG_IGN);
+    conn.fd = connect_socket(socket_path, FALSE);
+    if (conn.fd < 0)
+        return FAILED;
+    conn.start = conn.end = 0;
+
+    sprintf(header, "%s %s %u %d %ld\n", REQUEST_ASSEMBLE, REQUEST_SOURCE, load_base, memory_size, length);
+    replied = write_all(conn.fd, header, strlen(header)) && write_all(conn.fd, src, length) && read_result(&conn, result);
+    close(conn.fd);
+    return replied ? SUCCESS : FAILED;
+}
+
+/**
+ * @brief a worker of the server: serves the connections which it accepts, one at a time, with a context which it
+ * keeps for all of them.
+ *
+ * @param arg the server
+ * @return NULL
+ */
+static void *serve_worker(void *arg) {
+    server *srv = (server *)arg;
+    assembler_ctx *ctx;
+    text_buffer request; /* the payload of a request, its memory is reused by the next requests */
+    int fd;
+
+    ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+    assembler_init(ctx);
+    text_buffer_init(&request);
+
+    for (;;) {
+        fd = accept(srv->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        set_timeout(fd);
+        serve_connection(ctx, fd, &request);
+        close(fd);
+    }
+
+    text_buffer_free(&request);
+    assembler_free(ctx);
+    free(ctx);
+    return NULL;
+}
+
+/**
+ * @brief serves the request of a connection
+ *
+ * @param ctx the context of the worker
+ * @param fd the connection
+ * @param request the buffer of the payload of a request
+ */
+static void serve_connection(assembler_ctx *ctx, int fd, text_buffer *request) {
+    char header[MAX_HEADER_LENGTH];
+    char command[MAX_HEADER_LENGTH], kind[MAX_HEADER_LENGTH];
+    unsigned int load_base;
+    int memory_size;
+    long length, step;
+    assembly_result result;
+    connection conn;
+
+    conn.fd = fd;
+    conn.start = conn.end = 0;
+    if (!read_header(&conn, header))
+        return;
+    if (sscanf(header, "%s %s %u %d %ld", command, kind, &load_base, &memory_size, &length) != 5 ||
+        strcmp(command, REQUEST_ASSEMBLE) || strcmp(kind, REQUEST_SOURCE) ||
+        !valid_memory_options(load_base, memory_size) || length < 0 || length > MAX_REQUEST_LENGTH) {
+        send_error(fd, "Invalid request");
+        return;
+    }
+
+    /* the buffer grows with the payload which arrived (upto twice of it), so a header alone doesn't allocate the
+     * length which it claims */
+    request->length = 0;
+    while (request->length < length) {
+        step = length - request->length;
+        if (step > CONNECTION_BUFFER_SIZE + request->length)
+            step = CONNECTION_BUFFER_SIZE + request->length;
+        text_buffer_reserve(request, step);
+        if (!read_all(&conn, request->data + request->length, step))
+            return;
+        request->length += step;
+    }
+    request->data[length] = '\0';
+
+    ctx->load_base = load_base;
+    ctx->memory_size = memory_size;
+    assemble_buffer(ctx, request->data, request->length, &result);
+    send_result(fd, &result);
+    assembly_result_free(&result);
+}
+
+/**
+ * @brief sends the result of an assembly to a client
+ *
+ * @param fd the connection
+ * @param result the result of the assembly
+ */
+static void send_result(int fd, assembly_result *result) {
+    text_buffer *sections[NUM_RESULT_SECTIONS];
+    text_buffer reply; /* everything but the content of the sections */
+    char line[MAX_HEADER_LENGTH];
+    diagnostic *item;
+    int i;
+
+    text_buffer_init(&reply);
+    result_sections(result, sections);
+    sprintf(line, "%s %d %d", REPLY_RESULT,
+            (result->has_output ? RESULT_HAS_OUTPUT : 0) | (result->has_entries ? RESULT_HAS_ENTRIES : 0) |
+                (result->has_externals ? RESULT_HAS_EXTERNALS : 0),
+            result->num_diagnostics);
+    text_buffer_append(&reply, line, strlen(line));
+    for (i = 0; i < NUM_RESULT_SECTIONS; i++) {
+        sprintf(line, " %ld", sections[i]->length);
+        text_buffer_append(&reply, line, strlen(line));
+    }
+    text_buffer_append(&reply, "\n", 1);
+    for (i = 0; i < result->num_diagnostics; i++) {
+        item = &result->diagnostics[i];
+        sprintf(line, "%d %d %s\n", item->line_num, item->column, errors[item->code].key);
+        text_buffer_append(&reply, line, strlen(line));
+    }
+
+    if (write_all(fd, reply.data, reply.length)) {
+        for (i = 0; i < NUM_RESULT_SECTIONS && write_all(fd, sections[i]->data, sections[i]->length); i++)
+            ;
+    }
+    text_buffer_free(&reply);
+}
+
+/**
+ * @brief sends the reply of a request which failed
+ *
+ * @param fd the connection
+ * @param message the reason of the failure
+ */
+static void send_error(int fd, char *message) {
+    char line[MAX_HEADER_LENGTH];
+
+    sprintf(line, "%s %s\n", REPLY_ERROR, message);
+    write_all(fd, line, strlen(line));
+}
+
+/**
+ * @brief reads the reply of a server into the result of an assembly
+ *
+ * @param conn the connection
+ * @param result the result to fill, it's initialized only if the reply is a result
+ * @return true if the server replied with a complete result, otherwise false.
+ */
+static bool read_result(connection *conn, assembly_result *result) {
+    char header[MAX_HEADER_LENGTH];
+    char reply[MAX_HEADER_LENGTH], key[MAX_HEADER_LENGTH];
+    text_buffer *sections[NUM_RESULT_SECTIONS];
+    long lengths[NUM_RESULT_SECTIONS];
+    int flags, num_diagnostics, i, code;
+    diagnostic *item;
+    bool complete;
+
+    if (!read_header(conn, header) ||
+        sscanf(header, "%s %d %d %ld %ld %ld %ld %ld", reply, &flags, &num_diagnostics, &lengths[0], &lengths[1],
+               &lengths[2], &lengths[3], &lengths[4]) != 3 + NUM_RESULT_SECTIONS ||
+        strcmp(reply, REPLY_RESULT) || num_diagnostics < 0 || num_diagnostics > MAX_DIAGNOSTICS)
+        return FALSE;
+    for (i = 0; i < NUM_RESULT_SECTIONS; i++) {
+        if (lengths[i] < 0 || lengths[i] > MAX_REQUEST_LENGTH)
+            return FALSE;
+    }
+
+    result->has_output = (flags & RESULT_HAS_OUTPUT) != 0;
+    result->has_entries = (flags & RESULT_HAS_ENTRIES) != 0;
+    result->has_externals = (flags & RESULT_HAS_EXTERNALS) != 0;
+    result->diagnostics = NULL;
+    result->num_diagnostics = 0;
+    result_sections(result, sections);
+    for (i = 0; i < NUM_RESULT_SECTIONS; i++)
+        text_buffer_init(sections[i]);
+
+    /* the errors are sent by their keys, which don't depend on the order of the errors table */
+    if (num_diagnostics > 0)
+        result->diagnostics = (diagnostic *)malloc_w_check(sizeof(diagnostic) * num_diagnostics);
+    complete = TRUE;
+    for (i = 0; i < num_diagnostics && complete; i++) {
+        item = &result->diagnostics[result->num_diagnostics];
+        complete = read_header(conn, header) && sscanf(header, "%d %d %s", &item->line_num, &item->column, key) == 3;
+        for (code = 0; complete && code < NUM_ERRORS && strcmp(errors[code].key, key); code++)
+            ;
+        if (complete && code < NUM_ERRORS) {
+            item->code = code;
+            result->num_diagnostics++;
+        }
+    }
+
+    for (i = 0; i < NUM_RESULT_SECTIONS && complete; i++) {
+        text_buffer_reserve(sections[i], lengths[i]);
+        complete = read_all(conn, sections[i]->data, lengths[i]);
+        sections[i]->length = lengths[i];
+        sections[i]->data[lengths[i]] = '\0';
+    }
+
+    if (!complete)
+        assembly_result_free(result);
+    return complete;
+}
+
+/**
+ * @brief opens a connection to a unix socket, or a socket which accepts the connections at a path
+ *
+ * @param socket_path the path of the socket
+ * @param listening true to accept connections at the path, false to connect to it
+ * @return int the socket, or -1 if it failed.
+ */
+static int connect_socket(char *socket_path, bool listening) {
+    struct sockaddr_un address;
+    int fd;
+
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+        return -1;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (!listening) {
+        if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+            return fd;
+    } else {
+        if (remove_stale_socket(&address) && bind(fd, (struct sockaddr *)&address, sizeof(address)) == 0 && listen(fd, SERVER_BACKLOG) == 0)
+            return fd;
+    }
+    close(fd);
+    return -1;
+}
+
+/**
+ * @brief removes a socket which was left at a path by a server which stopped, so a new server can bind to the path.
+ * a socket which a server still accepts connections on, and anything which isn't a socket, are never removed.
+ *
+ * @param address the address of the socket
+ * @return SUCCESS if the path is free to bind to, otherwise FAILED.
+ */
+static status remove_stale_socket(struct sockaddr_un *address) {
+    struct stat info;
+    bool refused;
+    int fd;
+
+    if (stat(address->sun_path, &info) != 0)
+        return SUCCESS;
+    if (!S_ISSOCK(info.st_mode))
+        return FAILED;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return FAILED;
+    refused = connect(fd, (struct sockaddr *)address, sizeof(*address)) != 0 && errno == ECONNREFUSED;
+    close(fd);
+    if (!refused) {
+        printf("\nA server is already running on %s\n", address->sun_path);
+        return FAILED;
+    }
+    return unlink(address->sun_path) == 0 ? SUCCESS : FAILED;
+}
+
+/**
+ * @brief drops a connection which doesn't send or receive for SERVER_TIMEOUT_SECONDS, by failing its reads and writes
+ *
+ * @param fd the connection
+ */
+static void set_timeout(int fd) {
+    struct timeval timeout;
+
+    timeout.tv_sec = SERVER_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+/**
+ * @brief reads a line of a request or a reply, w/o its new line character.
+ * the connection is read a buffer at a time, and the bytes after the line are kept in the buffer for the next reads.
+ *
+ * @param conn the connection
+ * @param header the line, of upto MAX_HEADER_LENGTH characters (incl. the null terminator)
+ * @return SUCCESS if a complete line was read, FAILED at the end of the connection or if the line is too long.
+ */
+static status read_header(connection *conn, char *header) {
+    char *new_line;
+    long count;
+    int length;
+
+    for (;;) {
+        length = conn->end - conn->start;
+        new_line = (char *)memchr(conn->buffer + conn->start, '\n', length);
+        if (new_line != NULL) {
+            length = new_line - (conn->buffer + conn->start);
+            if (length >= MAX_HEADER_LENGTH)
+                return FAILED;
+            memcpy(header, conn->buffer + conn->start, length);
+            header[length] = '\0';
+            conn->start += length + 1;
+            return SUCCESS;
+        }
+        if (length >= MAX_HEADER_LENGTH)
+            return FAILED;
+
+        /* the start of the line is moved to the start of the buffer, and the rest of it is read after it */
+        memmove(conn->buffer, conn->buffer + conn->start, length);
+        conn->start = 0;
+        conn->end = length;
+        count = read(conn->fd, conn->buffer + conn->end, CONNECTION_BUFFER_SIZE - conn->end);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return FAILED;
+        conn->end += count;
+    }
+}
+
+/**
+ * @brief reads an exact number of bytes from a connection, starting with the bytes in its buffer
+ *
+ * @param conn the connection
+ * @param data the buffer to read to
+ * @param length number of bytes
+ * @return SUCCESS if all of them were read, FAILED if the connection ended before.
+ */
+static status read_all(connection *conn, char *data, long length) {
+    long count;
+
+    count = conn->end - conn->start < length ? conn->end - conn->start : length;
+    memcpy(data, conn->buffer + conn->start, count);
+    conn->start += count;
+    data += count;
+    length -= count;
+
+    while (length > 0) {
+        count = read(conn->fd, data, length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return FAILED;
+        data += count;
+        length -= count;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief writes an exact number of bytes to a connection
+ *
+ * @param fd the connection
+ * @param data the bytes to write
+ * @param length number of bytes
+ * @return SUCCESS if all of them were written, FAILED if the connection was closed.
+ */
+static status write_all(int fd, const char *data, long length) {
+    long count;
+
+    while (length > 0) {
+        count = write(fd, data, length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return FAILED;
+        data += count;
+        length -= count;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief the sections of a result, by their order in a reply
+ *
+ * @param result the result of an assembly
+ * @param sections the buffers of the result: the log, and the content of the .am, .ob, .ent and .ext files
+ */
+static void result_sections(assembly_result *result, text_buffer **sections) {
+    sections[0] = &result->log;
+    sections[1] = &result->expanded;
+    sections[2] = &result->object;
+    sections[3] = &result->entries;
+    sections[4] = &result->externals;
+}
@@ -0,0 +1,37 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "global.h"
+
+/* Declarations */
+#define REQUEST_ASSEMBLE "ASSEMBLE"         /* the first word of a request */
+#define REQUEST_SOURCE "SOURCE"             /* the request holds the content of the source */
+#define REPLY_RESULT "RESULT"               /* the first word of the reply of an assembled source */
+#define REPLY_ERROR "ERROR"                 /* the first word of the reply of a request which failed */
+#define MAX_HEADER_LENGTH 160               /* Maximum length of the first line of a request or a reply */
+#define MAX_REQUEST_LENGTH 1073741824L      /* Maximum length of the source of a request */
+#define SERVER_BACKLOG 64                   /* number of connections which wait for a worker */
+#define SERVER_TIMEOUT_SECONDS 10           /* a connection which doesn't send or receive for this long is dropped */
+#define CONNECTION_BUFFER_SIZE 4096         /* the bytes which are read from a connection at a time */
+
+/* an assembler server: a pool of workers, each with its own context, which accept requests on a unix socket */
+typedef struct {
+    char *socket_path; /* the path of the unix socket */
+    int listen_fd;     /* the socket which the workers accept the connections on */
+} server;
+
+/* a connection, with the bytes which were read from it and weren't used yet (e.g. the start of the payload, which
+ * was read together with the header) */
+typedef struct {
+    int fd;                              /* the socket of the connection */
+    char buffer[CONNECTION_BUFFER_SIZE]; /* the bytes which were read */
+    int start;                           /* index of the first byte in the buffer which wasn't used */
+    int end;                             /* number of bytes in the buffer */
+} connection;
+
+/* Prototypes */
+status run_server(char *socket_path, int num_workers);
+status remote_assemble(char *socket_path, const char *src, long length, unsigned int load_base, int memory_size,
+                       assembly_result *result);
+
+#endif
@@ -0,0 +1,440 @@
+/**
+ * @file session.c
+ * @brief this file includes the assembly sessions, which keep a source assembled while it's edited (e.g. by an editor
+ * which shows the errors as the user types). the lines of the source are compiled in blocks, each by its own context
+ * with addresses and labels relative to the block, like the chunks of the first pass in parallel. an edit replaces a
+ * range of lines, and only the blocks of the lines which changed are compiled (lexed and parsed) again: the blocks
+ * after the edit are kept as they are, and are shifted by the number of lines and words before them as the blocks are
+ * merged to the first pass of the whole source. the merged labels are then resolved, and the instructions encoded.
+ *
+ * the lines which changed are found by comparing the text before and after the edit, so an edit of a macro (which
+ * changes every line it's expanded to) is handled like any other edit. a source with a label that is defined by
+ * 2 blocks, or that is checked against the labels of the previous blocks, or which overflows the memory, is compiled
+ * again by a single context, so the errors of a session are always the same as assembling the whole source.
+ */
+
+#include "session.h"
+#include "arena.h"
+#include "assembler.h"
+#include "parallel_stage_1.h"
+#include "pre_processor.h"
+#include "scanner.h"
+#include "stage_1.h"
+#include "stage_2.h"
+#include "string_pool.h"
+#include "symbols_table.h"
+#include "utils.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define COMPARE_BLOCK_SIZE 4096 /* the texts are compared by blocks of this number of characters, then by characters */
+
+/* Prototypes */
+static bool has_macros(assembler_ctx *ctx, line_index *lines, text_buffer *source);
+static long common_prefix(text_buffer *a, text_buffer *b);
+static long common_suffix(text_buffer *a, text_buffer *b, long prefix);
+static long find_line_end(line_index *lines, long offset);
+static long find_line_start(line_index *lines, long offset);
+static void update_blocks(assembly_session *s, long first, long old_tail, long delta);
+static void compile_block(assembly_session *s, session_block *block);
+static void merge_blocks(assembly_session *s);
+static void reset_pass(assembler_ctx *ctx);
+
+/**
+ * @brief initialize a session of an empty source. the context of the session (s->ctx) can be set up before the
+ * source is loaded, e.g. its load base.
+ *
+ * @param s the session to initialize
+ */
+void session_init(assembly_session *s) {
+    int i;
+
+    s->ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+    assembler_init(s->ctx);
+    for (i = 0; i < 2; i++) {
+        text_buffer_init(&s->source[i]);
+        text_buffer_init(&s->expanded[i]);
+        lines_init(&s->lines[i]);
+    }
+    text_buffer_init(&s->log);
+    s->current = 0;
+    s->plain = TRUE;
+    s->num_blocks = 0;
+    s->blocks_capacity = 0;
+    s->blocks = NULL;
+
+    s->diagnostics = s->ctx->diagnostics.items;
+    s->num_diagnostics = s->dropped_diagnostics = 0;
+    s->has_output = TRUE;
+    s->code = s->data = NULL;
+    s->code_size = s->data_size = 0;
+    s->compiled_lines = 0;
+}
+
+/**
+ * @brief free the memory which was allocated to a session
+ *
+ * @param s the session to free
+ */
+void session_free(assembly_session *s) {
+    int i;
+
+    for (i = 0; i < s->num_blocks; i++) {
+        assembler_free(s->blocks[i].ctx);
+        free(s->blocks[i].ctx);
+    }
+    free(s->blocks);
+    for (i = 0; i < 2; i++) {
+        text_buffer_free(&s->source[i]);
+        text_buffer_free(&s->expanded[i]);
+        lines_free(&s->lines[i]);
+    }
+    text_buffer_free(&s->log);
+    assembler_free(s->ctx);
+    free(s->ctx);
+    s->ctx = NULL;
+    s->blocks = NULL;
+    s->num_blocks = s->blocks_capacity = 0;
+}
+
+/**
+ * @brief replaces the whole source of a session, and assembles it
+ *
+ * @param s the session
+ * @param src the source code (the content of a .as file)
+ * @param length length of the source code
+ */
+void session_load(assembly_session *s, const char *src, long length) {
+    session_edit(s, 0, LONG_MAX, src, length);
+}
+
+/**
+ * @brief replaces a range of lines of the source of a session with a text, and assembles the source again.
+ * only the blocks of the lines which changed are compiled, and the result of the session is updated.
+ *
+ * @param s the session
+ * @param first_line index of the first line to replace (0 for the first line of the source)
+ * @param num_lines number of lines to replace, 0 to insert the text before the first line
+ * @param text the new lines, each with its new line character (the last line of the source may not have one)
+ * @param length length of the text
+ */
+void session_edit(assembly_session *s, long first_line, long num_lines, const char *text, long length) {
+    assembler_ctx *ctx = s->ctx;
+    int next = 1 - s->current;
+    text_buffer *source = &s->source[s->current];
+    text_buffer *old_text = s->plain ? source : &s->expanded[s->current];
+    text_buffer *new_text;
+    line_index *old_lines = &s->lines[s->current];
+    line_index *new_lines = &s->lines[next];
+    line_index *source_lines = s->plain ? old_lines : &ctx->lines; /* the pre-processor splits the source */
+    long start, end, prefix, suffix, first, old_tail, new_offset;
+
+    /* the offsets of the lines to replace */
+    if (first_line > source_lines->count)
+        first_line = source_lines->count;
+    if (num_lines > source_lines->count - first_line)
+        num_lines = source_lines->count - first_line;
+    start = first_line < source_lines->count ? source_lines->items[first_line].start : source->length;
+    end = first_line + num_lines < source_lines->count ? source_lines->items[first_line + num_lines].start : source->length;
+
+    /* the next source: the lines before the edit, the text of the edit and the lines after it */
+    s->source[next].length = 0;
+    s->source[next].data[0] = '\0';
+    text_buffer_append(&s->source[next], source->data, start);
+    text_buffer_append(&s->source[next], (char *)text, length);
+    text_buffer_append(&s->source[next], source->data + end, source->length - end);
+
+    /* a source without macros is compiled as is */
+    ctx->log = &s->log;
+    s->log.length = 0;
+    arena_reset(&ctx->temps);
+    pool_reset(&ctx->names);
+    split_lines(new_lines, s->source[next].data, s->source[next].length);
+    if (has_macros(ctx, new_lines, &s->source[next])) {
+        s->expanded[next].length = 0;
+        s->expanded[next].data[0] = '\0';
+        pre_processor(ctx, s->source[next].data, s->source[next].length, &s->expanded[next]);
+        new_text = &s->expanded[next];
+        split_lines(new_lines, new_text->data, new_text->length);
+    } else
+        new_text = &s->source[next];
+
+    /* the lines which changed: the lines before them are the same, and so are the lines after them */
+    prefix = common_prefix(old_text, new_text);
+    suffix = common_suffix(old_text, new_text, prefix);
+    if (prefix == old_text->length && prefix == new_text->length)
+        prefix = suffix = old_text->length; /* the text didn't change */
+    first = find_line_end(old_lines, prefix);
+    if (first > 0 && old_text->data[old_lines->items[first - 1].start + old_lines->items[first - 1].length - 1] != '\n')
+        first--; /* the last line of the text grew */
+    old_tail = find_line_start(old_lines, old_text->length - suffix);
+    if (old_tail < old_lines->count && old_lines->items[old_tail].start == old_text->length - suffix) {
+        /* the line starts where the same text starts, check that it's still a separate line after the edit */
+        new_offset = old_lines->items[old_tail].start + new_text->length - old_text->length;
+        if (new_offset > 0 && new_text->data[new_offset - 1] != '\n')
+            old_tail++;
+    }
+    if (old_tail < first)
+        old_tail = first;
+
+    s->current = next;
+    s->plain = new_text == &s->source[next];
+    s->compiled_lines = 0;
+    update_blocks(s, first, old_tail, new_lines->count - old_lines->count);
+    merge_blocks(s);
+
+    s->diagnostics = ctx->diagnostics.items;
+    s->num_diagnostics = ctx->diagnostics.count;
+    s->dropped_diagnostics = ctx->diagnostics.dropped;
+    s->has_output = !ctx->error_occured_flag;
+    s->code = ctx->instr_memory.words;
+    s->code_size = ctx->ic;
+    s->data = ctx->data_memory.words;
+    s->data_size = ctx->dc;
+    ctx->log = NULL;
+}
+
+/**
+ * @brief checks if a source defines a macro, so it needs the pre-processor. only the lines which contain the
+ * word "macro" are tokenized, and checked like the pre-processor checks them.
+ *
+ * @param ctx the context of the session
+ * @param lines the lines of the source
+ * @param source a source
+ * @return true if a line of the source starts the definition of a macro
+ */
+static bool has_macros(assembler_ctx *ctx, line_index *lines, text_buffer *source) {
+    char *word = "macro";
+    char *c = source->data;
+    char *end = source->data + source->length;
+    long length = (long)strlen(word);
+    long line;
+
+    while ((c = (char *)memchr(c, word[0], end - c)) != NULL) {
+        if (end - c >= length && !memcmp(c, word, length)) {
+            line = find_line_end(lines, c - source->data);
+            if (is_macro_definition(ctx, lines, source->data, line))
+                return TRUE;
+            /* the rest of the line can't start a definition */
+            c = source->data + lines->items[line].start + lines->items[line].length;
+        } else
+            c++;
+    }
+    return FALSE;
+}
+
+/**
+ * @return long number of characters at the start of 2 texts which are the same
+ */
+static long common_prefix(text_buffer *a, text_buffer *b) {
+    long length = a->length < b->length ? a->length : b->length;
+    long i = 0;
+
+    while (i + COMPARE_BLOCK_SIZE <= length && !memcmp(a->data + i, b->data + i, COMPARE_BLOCK_SIZE))
+        i += COMPARE_BLOCK_SIZE;
+    while (i < length && a->data[i] == b->data[i])
+        i++;
+    return i;
+}
+
+/**
+ * @param prefix the length of the common prefix of the texts, which the suffix doesn't overlap
+ * @return long number of characters at the end of 2 texts which are the same
+ */
+static long common_suffix(text_buffer *a, text_buffer *b, long prefix) {
+    long length = (a->length < b->length ? a->length : b->length) - prefix;
+    char *a_end = a->data + a->length;
+    char *b_end = b->data + b->length;
+    long i = 0;
+
+    while (i + COMPARE_BLOCK_SIZE <= length && !memcmp(a_end - i - COMPARE_BLOCK_SIZE, b_end - i - COMPARE_BLOCK_SIZE, COMPARE_BLOCK_SIZE))
+        i += COMPARE_BLOCK_SIZE;
+    while (i < length && a_end[-i - 1] == b_end[-i - 1])
+        i++;
+    return i;
+}
+
+/**
+ * @param lines the lines of a text
+ * @param offset an offset in the text
+ * @return long number of lines which end at the offset or before it
+ */
+static long find_line_end(line_index *lines, long offset) {
+    long low = 0, high = lines->count, middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (lines->items[middle].start + lines->items[middle].length <= offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @param lines the lines of a text
+ * @param offset an offset in the text
+ * @return long index of the first line which starts at the offset or after it
+ */
+static long find_line_start(line_index *lines, long offset) {
+    long low = 0, high = lines->count, middle;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (lines->items[middle].start < offset)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/**
+ * @brief replaces the blocks of the lines which changed by new blocks, which are compiled, and moves the blocks after
+ * them. the blocks around the edit are compiled again with it, so the blocks don't get smaller with every edit.
+ *
+ * @param s the session, whose current lines are the lines after the edit
+ * @param first index of the first line which changed
+ * @param old_tail index of the first line after the lines which changed, before the edit
+ * @param delta number of lines which were added by the edit (negative if removed)
+ */
+static void update_blocks(assembly_session *s, long first, long old_tail, long delta) {
+    long old_count = s->lines[s->current].count - delta;
+    long limit = old_tail > first ? old_tail : first + 1;
+    long dirty_first = first, dirty_end = old_tail, num_lines;
+    assembler_ctx **spare;
+    session_block *block;
+    int bi, bj, i, num_new, num_spare;
+
+    if (first == old_tail && delta == 0)
+        return; /* the text didn't change */
+
+    /* the blocks which overlap the lines which changed, an insertion at the end changes the last block */
+    for (bi = 0; bi < s->num_blocks && (first < old_count ? s->blocks[bi].end_line <= first : s->blocks[bi].end_line < first); bi++)
+        ;
+    for (bj = bi; bj < s->num_blocks && s->blocks[bj].first_line < limit; bj++)
+        ;
+    if (bi < bj) {
+        if (s->blocks[bi].first_line < dirty_first)
+            dirty_first = s->blocks[bi].first_line;
+        if (s->blocks[bj - 1].end_line > dirty_end)
+            dirty_end = s->blocks[bj - 1].end_line;
+    }
+
+    /* the lines of the changed blocks after the edit, in blocks of about the same size */
+    num_lines = dirty_end + delta - dirty_first;
+    num_new = (int)(num_lines / SESSION_BLOCK_LINES);
+    if (num_new == 0 && num_lines > 0)
+        num_new = 1;
+
+    /* the contexts of the old blocks are reused by the new blocks */
+    spare = (assembler_ctx **)arena_alloc(&s->ctx->temps, sizeof(assembler_ctx *) * (bj - bi + 1));
+    for (i = bi, num_spare = 0; i < bj; i++)
+        spare[num_spare++] = s->blocks[i].ctx;
+    while (num_spare > num_new) {
+        num_spare--;
+        assembler_free(spare[num_spare]);
+        free(spare[num_spare]);
+    }
+
+    if (s->num_blocks - (bj - bi) + num_new > s->blocks_capacity) {
+        s->blocks_capacity = s->blocks_capacity == 0 ? 16 : s->blocks_capacity * 2;
+        if (s->blocks_capacity < s->num_blocks - (bj - bi) + num_new)
+            s->blocks_capacity = s->num_blocks - (bj - bi) + num_new;
+        s->blocks = (session_block *)realloc_w_check(s->blocks, sizeof(session_block) * s->blocks_capacity);
+    }
+    memmove(s->blocks + bi + num_new, s->blocks + bj, sizeof(session_block) * (s->num_blocks - bj));
+    s->num_blocks += num_new - (bj - bi);
+
+    for (i = 0; i < num_new; i++) {
+        block = &s->blocks[bi + i];
+        if (i < num_spare)
+            block->ctx = spare[i];
+        else {
+            block->ctx = (assembler_ctx *)malloc_w_check(sizeof(assembler_ctx));
+            assembler_init(block->ctx);
+            block->ctx->memory_size = 0; /* the memory is checked when the blocks are merged */
+        }
+        block->first_line = dirty_first + num_lines * i / num_new;
+        block->end_line = dirty_first + num_lines * (i + 1) / num_new;
+        compile_block(s, block);
+    }
+
+    for (i = bi + num_new; i < s->num_blocks; i++) {
+        s->blocks[i].first_line += delta;
+        s->blocks[i].end_line += delta;
+    }
+}
+
+/**
+ * @brief compiles the lines of a block by its own context, from an empty first pass
+ *
+ * @param s the session
+ * @param block the block
+ */
+static void compile_block(assembly_session *s, session_block *block) {
+    text_buffer *text = s->plain ? &s->source[s->current] : &s->expanded[s->current];
+
+    pool_reset(&block->ctx->names);
+    reset_pass(block->ctx);
+    compile_lines(block->ctx, &s->lines[s->current], text->data, block->first_line, block->end_line);
+    block->compiled_line = block->first_line;
+    s->compiled_lines += block->end_line - block->first_line;
+}
+
+/**
+ * @brief merges the blocks to the first pass of the whole source, and resolves its labels.
+ * when the blocks depend on each other, the whole source is compiled by the context of the session.
+ *
+ * @param s the session
+ */
+static void merge_blocks(assembly_session *s) {
+    assembler_ctx *ctx = s->ctx;
+    text_buffer *text = s->plain ? &s->source[s->current] : &s->expanded[s->current];
+    line_index *lines = &s->lines[s->current];
+    bool merged = TRUE;
+    session_block *block;
+    int i;
+
+    reset_pass(ctx);
+    for (i = 0; i < s->num_blocks && merged; i++) {
+        block = &s->blocks[i];
+        merged = !block->ctx->unchecked_label &&
+                 append_first_pass(ctx, block->ctx, (int)(block->first_line - block->compiled_line));
+    }
+    if (merged && ctx->memory_size > 0 && ctx->load_base + ctx->ic + ctx->dc > (unsigned int)ctx->memory_size)
+        merged = FALSE; /* the error is reported at the line which overflows */
+
+    if (!merged) {
+        reset_pass(ctx);
+        compile_lines(ctx, lines, text->data, 0, lines->count);
+        s->compiled_lines = lines->count;
+    }
+
+    relocate_sections(&ctx->symbols_tbl, ctx->load_base, ctx->ic);
+    if (!ctx->error_occured_flag)
+        resolve_labels(ctx);
+    arena_reset(&ctx->temps);
+}
+
+/**
+ * @brief clears the first pass of a context (its labels, instructions, data and errors), and keeps its memory.
+ * the names of the labels are kept in the pool (the pool of the session is cleared before its macros are read).
+ *
+ * @param ctx the context
+ */
+static void reset_pass(assembler_ctx *ctx) {
+    symbols_reset(&ctx->symbols_tbl);
+    ctx->instructions.count = 0;
+    ctx->fixups.count = 0;
+    ctx->externs.count = 0;
+    ctx->ic = ctx->dc = 0;
+    ctx->entry_exists = ctx->extern_exists = FALSE;
+    ctx->unchecked_label = FALSE;
+    ctx->error_occured_flag = FALSE;
+    ctx->diagnostics.count = ctx->diagnostics.dropped = 0;
+    begin_line(ctx, NULL);
+}
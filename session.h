@@ -0,0 +1,49 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "global.h"
+
+/* Declarations */
+#define SESSION_BLOCK_LINES 4096 /* the lines of a session are compiled in blocks of about this number of lines */
+
+/* a block of lines of a session, which is compiled by its own context, with its own labels, ic and dc (like a chunk
+ * of the first pass in parallel), so an edit compiles only the blocks which it changed */
+typedef struct {
+    assembler_ctx *ctx; /* the first pass of the block */
+    long first_line;    /* index of the first line of the block */
+    long end_line;      /* index of the line after the last line of the block */
+    long compiled_line; /* index of the first line when the block was compiled, which its line numbers refer to */
+} session_block;
+
+/* an assembly of a source which is edited a range of lines at a time (e.g. by an editor), and is kept assembled */
+typedef struct {
+    assembler_ctx *ctx;       /* the whole source: its macros, symbols table, instructions and memory images */
+    text_buffer source[2];    /* the source, and the buffer of the source after the next edit */
+    text_buffer expanded[2];  /* the source after expanding macros, and the buffer of the next one */
+    line_index lines[2];      /* the lines of the compiled text, and the lines of the next one */
+    int current;              /* index of the current source, expanded source and lines */
+    bool plain;               /* true if the source has no macros, so the source itself is compiled */
+    session_block *blocks;    /* the blocks, by order of lines */
+    int num_blocks;           /* number of blocks */
+    int blocks_capacity;      /* allocated length of the blocks array */
+    text_buffer log;          /* the messages of the pre-processor, which aren't kept */
+
+    /* the result of the last edit, which is valid until the next one */
+    diagnostic *diagnostics;  /* the errors of the source, by order of lines (upto MAX_DIAGNOSTICS) */
+    int num_diagnostics;      /* number of errors in the diagnostics array */
+    int dropped_diagnostics;  /* number of errors which didn't fit in the diagnostics array */
+    bool has_output;          /* true if there are no errors, so the words are the object of the source */
+    machine_word *code;       /* the words of the instructions */
+    int code_size;            /* number of words of the instructions (the ic) */
+    machine_word *data;       /* the words of the data, which follow the instructions */
+    int data_size;            /* number of words of the data (the dc) */
+    long compiled_lines;      /* number of lines which were compiled by the last edit, the others were kept */
+} assembly_session;
+
+/* Prototypes */
+void session_init(assembly_session *s);
+void session_free(assembly_session *s);
+void session_load(assembly_session *s, const char *src, long length);
+void session_edit(assembly_session *s, long first_line, long num_lines, const char *text, long length);
+
+#endif
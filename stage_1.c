@@ -8,115 +8,166 @@
 
 /**
  * @brief Function which is managing in high level the first stage.
- * the main purpose of this function is to compile the .am file and to collect all the
- * information which is needed to create a table that from that in the second stage it will be transformed to
- * 32 base code.
+ * the main purpose of this function is to compile the expanded source in a single pass: every word of the data is
+ * encoded to memory, and every command is parsed to an instruction record (and .entry directives to fixups), so in the
+ * second stage the instructions are encoded without reading the file again, and then transformed to 32 base code.
  *
- * @param curr_file the current file to compile. it's the .am file.
- * @param filename the file name w/o its extension.
+ * @param ctx the assembler context
+ * @param source the source to compile, after expanding macros.
  */
-void stage_1(FILE *curr_file, char *filename) {
-    char temp_line[MAX_LINE_LENGTH]; /* temporary string for storing line, read from file */
-    int line_count = 1;
-    ic = dc = 0;
-    error_occured_flag = FALSE;
-
-    printf("\n __________________________\n");
-    printf("|         STAGE 1#         |\n");
-    printf(" ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
-
-    printf("* Compiling...\n");
-    /* Read lines until end of file */
-    while (fgets(temp_line, MAX_LINE_LENGTH, curr_file) != NULL) {
-        set_error("NO_ERROR");
-        read_line_stage_1(temp_line, line_count);
-
-        line_count++; /* increment line counter */
-    }
+void stage_1(assembler_ctx *ctx, text_buffer *source) {
+    ctx->ic = ctx->dc = 0;
+    ctx->error_occured_flag = FALSE;
+
+    print_log(ctx, "\n __________________________\n");
+    print_log(ctx, "|         STAGE 1#         |\n");
+    print_log(ctx, " ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
+
+    print_log(ctx, "* Compiling...\n");
+    /* Read lines until end of file, straight from the source. a large source is compiled over chunks in parallel */
+    split_lines(&ctx->lines, source->data, source->length);
+    if (!stage_1_parallel(ctx, source->data))
+        compile_lines(ctx, &ctx->lines, source->data, 0, ctx->lines.count);
 
     /* When the first pass ends and the symbols table is complete and IC is evaluated,
-       we can calculate real final addresses */
-    proceed_addr(symbols_tbl, IC_INIT_ADDR, FALSE);     /* Instruction symbols will have addresses that start from 100 (MEMORY_START) */
-    proceed_addr(symbols_tbl, ic + IC_INIT_ADDR, TRUE); /* Data symbols will have addresses that start fron NENORY_START + IC */
+       we can place the sections: instructions start at the load base, and data right after them */
+    relocate_sections(&ctx->symbols_tbl, ctx->load_base, ctx->ic);
 
-    printf("* Finished stage 1.\n");
+    print_log(ctx, "* Finished stage 1.\n");
+}
+
+/**
+ * @brief compiles a range of lines of the source by order.
+ *
+ * @param ctx the assembler context
+ * @param lines the lines of the source
+ * @param text the source
+ * @param first index of the first line to compile
+ * @param end index of the line after the last line to compile
+ */
+void compile_lines(assembler_ctx *ctx, line_index *lines, char *text, long first, long end) {
+    unsigned long limit = (unsigned long)ctx->memory_size;
+    unsigned long size, new_size;
+    long i;
+
+    for (i = first; i < end; i++) {
+        size = ctx->load_base + ctx->ic + ctx->dc; /* the end address of the program */
+        begin_line(ctx, text + lines->items[i].start);
+        tokenize_line(&ctx->tokens, lines, text, i);
+        read_line_stage_1(ctx, &ctx->tokens, (int)i + 1);
+
+        /* the program crossed the end of the memory on this line, so only the first line which overflows is
+         * reported (the program only grows), and the following lines are still compiled */
+        new_size = ctx->load_base + ctx->ic + ctx->dc;
+        if (limit > 0 && size <= limit && new_size > limit)
+            throw_err(ctx, ERR_MEMORY_OVERFLOW, (int)i + 1);
+    }
+    begin_line(ctx, NULL);
+}
+
+/**
+ * @brief reads a token of the current line, and marks it as the last token which was read (for the column of errors).
+ *
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param i index of the token to read
+ * @return token* the token, or NULL if the line ended before it.
+ */
+static token *read_token(assembler_ctx *ctx, token_list *tokens, int i) {
+    if (i >= tokens->count)
+        return NULL;
+    mark_token(ctx, TOKEN_TEXT(tokens, i));
+    return &tokens->items[i];
 }
 
 /**
- * @brief Function which gets a line of code and a number of the line,
+ * @brief Function which gets the tokens of a line of code and a number of the line,
  * this function checks if there is a label in the line,
  * and if the line is a directive instruction or command instruction.
  * it treats this line according to its identity.
  *
- * @param line string which reperesents a line of code
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
  * @param line_num  the number of the line in code
  * @return status returns the status of success if there were errors while compiling the code.
  */
-status read_line_stage_1(char *line, int line_num) {
-    char curr_word[MAX_LINE_LENGTH];
+status read_line_stage_1(assembler_ctx *ctx, token_list *tokens, int line_num) {
+    char *word, *label_name = NULL;
+    int label_length = 0;
+    int first = 0;                     /* index of the first token of the instruction */
+    int end = word_end(tokens, first); /* index of the token after the instruction */
     label_ptr label_node = NULL;
     bool label_exists = FALSE;
     int instruction_index = 0;
+    keyword instruction;
 
     /* Ignore line if it's blank or a comment */
-    if (is_ignore_line(line))
+    if (tokens->count == 0 || *TOKEN_TEXT(tokens, 0) == ';')
         return NO_ERROR; /* skip to next line */
 
-    line = skip_spaces(line);
-    copy_word(curr_word, line);
-
     /* check if first word is a label */
-    if (is_label(curr_word, TRUE)) {
+    word = TOKEN_TEXT(tokens, first);
+    read_token(ctx, tokens, first);
+    if (is_label(ctx, word, TOKENS_LENGTH(tokens, first, end), TRUE)) {
         label_exists = TRUE;
-        if (is_end_of_line(line)) {
-            throw_err("ONLY_LABEL_IN_LINE", line_num);
-            return ERROR;
-        }
+        label_name = word;
+        label_length = (char *)memchr(word, ':', TOKENS_LENGTH(tokens, first, end)) - word; /* the label ends at the colon */
 
-        strtok(curr_word, ":"); /* trim colon at end of he row */
-        /* Add label to symbols table */
-        label_node = insert_label(&symbols_tbl, curr_word, 0, FALSE, FALSE);
-        if (print_error(line_num))
-            return ERROR; /* check for errors in internal function like is_label */
+        /* continue to next word */
+        first = end;
+        end = word_end(tokens, first);
+        read_token(ctx, tokens, first);
+    }
 
-        if (label_node == NULL) { /* There was an error creating label */
-            throw_err("LABEL_INSERT_FAILED", line_num);
-            return ERROR;
-        }
+    if (first < tokens->count)
+        instruction = classify_span(TOKEN_TEXT(tokens, first), TOKENS_LENGTH(tokens, first, end));
+    else
+        instruction = classify_span(label_name, label_length); /* the line is a label alone */
+    instruction_index = instruction.index;
+
+    if (label_exists) {
+        mark_token(ctx, label_name); /* errors of the label are located at the label */
+        if (instruction.kind == WORD_DIRECTIVE && (instruction_index == EXTERN || instruction_index == ENTRY)) {
+            /* we need to ignore creation of label before .entry/.extern, but it still can't be defined twice */
+            label_exists = FALSE;
+            if (get_label(&ctx->symbols_tbl, label_name, label_length) != NULL)
+                set_error(ctx, ERR_LABEL_ALREADY_EXISTS);
+            else
+                ctx->unchecked_label = TRUE; /* a chunk of the source can't tell if a previous chunk defines it */
+        } else {
+            /* Add label to symbols table */
+            label_node = insert_label(ctx, label_name, label_length, SECTION_DATA, 0);
+            if (report_error(ctx, line_num))
+                return ERROR; /* check for errors in internal function like is_label */
 
-        /* continue to next word */
-        line = next_word(line);
-        copy_word(curr_word, line);
+            if (label_node == NULL) { /* There was an error creating label */
+                throw_err(ctx, ERR_LABEL_INSERT_FAILED, line_num);
+                return ERROR;
+            }
+        }
     }
 
-    if (print_error(line_num))
+    if (report_error(ctx, line_num))
         return ERROR; /* check for errors in internal function like is_label */
 
     /* check if instruction is of type directive */
-    if ((instruction_index = find_directive(curr_word)) != NOT_FOUND) {
+    if (instruction.kind == WORD_DIRECTIVE) {
+        if (label_exists)
+            label_node->offset = ctx->dc; /* Address of data label is dc */
+        directive_handler(ctx, instruction_index, tokens, end, line_num);
+    } else if (instruction.kind == WORD_COMMAND) {
         if (label_exists) {
-            if (instruction_index == EXTERN || instruction_index == ENTRY) { /* we need to ignore creation of label before .entry/.extern */
-                delete_label(&symbols_tbl, label_node->name);
-                label_exists = FALSE;
-            } else
-                label_node->address = dc; /* Address of data label is dc */
+            label_node->section = SECTION_CODE;
+            label_node->offset = ctx->ic;
         }
-        line = next_word(line);
-        directive_handler(instruction_index, line);
-    } else if ((instruction_index = find_command(curr_word)) != NOT_FOUND) {
-        if (label_exists) {
-            label_node->activeRow = TRUE;
-            label_node->address = ic;
-        }
-        line = next_word(line);
-        command_handler(instruction_index, line);
+        command_handler(ctx, instruction_index, tokens, end, line_num);
     } else {
-        throw_err("INSTRUCTION_NOT_FOUND", line_num);
+        throw_err(ctx, ERR_INSTRUCTION_NOT_FOUND, line_num);
         return ERROR;
     }
 
     /* if error occured in commannd handler or in directive handler */
-    if (print_error(line_num))
+    if (report_error(ctx, line_num))
         return ERROR;
 
     return NO_ERROR;
@@ -125,37 +176,40 @@ status read_line_stage_1(char *line, int line_num) {
 /**
  * @brief function which handles line of code which incl. a directive instruction
  *
+ * @param ctx the assembler context
  * @param instruction_index the type of the directive instruction
- * @param line string which represents the line
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operands
+ * @param line_num the number of the line in code
  * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
  */
-status directive_handler(int instruction_index, char *line) {
+status directive_handler(assembler_ctx *ctx, int instruction_index, token_list *tokens, int first, int line_num) {
     /* check if this directive instruction have at least one operand  */
-    if (line == NULL || is_end_of_line(line)) {
-        set_error("DIRECTIVE_NO_OPERANDS");
+    if (first >= tokens->count) {
+        set_error(ctx, ERR_DIRECTIVE_NO_OPERANDS);
         return ERROR;
     }
 
     switch (instruction_index) {
     case DATA:
-        return data_directive_handler(line);
+        return data_directive_handler(ctx, tokens, first);
 
     case STRING:
-        return string_directive_handler(line);
+        return string_directive_handler(ctx, tokens, first);
 
     case STRUCT:
-        return struct_directive_handler(line);
+        return struct_directive_handler(ctx, tokens, first);
 
     case ENTRY:
         /*check if there is one operand only*/
-        if (!is_end_of_line(next_word(line))) {
-            set_error("DIRECTIVE_INVALID_NUM_PARAMS");
+        if (word_end(tokens, first) < tokens->count) {
+            set_error(ctx, ERR_DIRECTIVE_INVALID_NUM_PARAMS);
             return ERROR;
         }
-        break;
+        return entry_directive_handler(ctx, tokens, first, line_num);
 
     case EXTERN:
-        return extern_directive_handler(line);
+        return extern_directive_handler(ctx, tokens, first);
     }
 
     return NO_ERROR;
@@ -164,33 +218,41 @@ status directive_handler(int instruction_index, char *line) {
 /**
  * @brief function which handles line of code which incl. a command instruction
  *
+ * @param ctx the assembler context
  * @param instruction_index the type of the directive instruction
- * @param line string which represents the line
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operands
+ * @param line_num the number of the line in code
  * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
  */
-status command_handler(int instruction_index, char *line) {
+status command_handler(assembler_ctx *ctx, int instruction_index, token_list *tokens, int first, int line_num) {
     bool is_first = FALSE, is_second = FALSE;
-    int first_operand_addr_method, second_operand_addr_method;
-    char first_operand[OPERAND_MAX_LEN], second_operand[OPERAND_MAX_LEN];
+    int first_operand = first, second_operand = first + 2; /* the operands are separated by a comma token */
+    operand first_op, second_op, src_op, dest_op;
+    const command_descriptor *command;
+    instruction *instr;
+    token *tok;
 
-    line = copy_next_li_word(first_operand, line);
-    if (!is_end_of_line(first_operand)) /* If first operand is not empty */
+    first_op.method = second_op.method = ADDR_UNKNOWN;
+    first_op.label_id = second_op.label_id = NOT_FOUND;
+    first_op.value = second_op.value = 0;
+
+    if (read_token(ctx, tokens, first_operand) != NULL) /* If first operand is not empty */
     {
         is_first = TRUE; /* First operand exists! */
-        line = copy_next_li_word(second_operand, line);
-        if (!is_end_of_line(second_operand)) /* If second operand (should hold temporarily a comma) is not empty */
+        tok = read_token(ctx, tokens, first_operand + 1);
+        if (tok != NULL) /* If there is a token after the first operand (should be a comma) */
         {
             /* A comma must separate two operands of a command */
-            if (second_operand[0] != ',') {
-                set_error("COMMAND_UNEXPECTED_CHAR");
+            if (tok->kind != TOKEN_COMMA) {
+                set_error(ctx, ERR_COMMAND_UNEXPECTED_CHAR);
                 return ERROR;
             }
 
             else {
-                line = copy_next_li_word(second_operand, line);
-                if (is_end_of_line(second_operand)) /* If second operand is not empty */
+                if (read_token(ctx, tokens, second_operand) == NULL) /* If second operand is empty */
                 {
-                    set_error("COMMAND_UNEXPECTED_CHAR");
+                    set_error(ctx, ERR_COMMAND_UNEXPECTED_CHAR);
                     return ERROR;
                 }
                 is_second = TRUE; /* Second operand exists! */
@@ -198,36 +260,50 @@ status command_handler(int instruction_index, char *line) {
         }
     }
 
-    line = skip_spaces(line);
-    if (!is_end_of_line(line)) /* If the line continues after two operands */
+    if (second_operand + 1 < tokens->count) /* If the line continues after two operands */
     {
-        set_error("COMMAND_TOO_MANY_OPERANDS");
+        set_error(ctx, ERR_COMMAND_TOO_MANY_OPERANDS);
         return ERROR;
     }
 
     if (is_first)
-        first_operand_addr_method = get_addr_method(first_operand); /* Detect addressing method of first operand */
+        parse_operand(ctx, tokens, first_operand, &first_op); /* Detect addressing method of first operand */
     if (is_second)
-        second_operand_addr_method = get_addr_method(second_operand); /* Detect addressing method of second operand */
+        parse_operand(ctx, tokens, second_operand, &second_op); /* Detect addressing method of second operand */
 
     /* If there was no error while trying to parse addressing methods */
-    if (!is_error_exists()) {
+    if (!is_error_exists(ctx)) {
+        command = &command_set[instruction_index];
+
         /* If number of operands is valid for this specific command */
-        if (command_accept_num_operands(instruction_index, is_first, is_second)) {
-            /* If addressing methods are valid for this specific command */
-            if (command_accept_methods(instruction_index, first_operand_addr_method, second_operand_addr_method)) {
+        if (command->num_operands == is_first + is_second) {
+            /* first operand is the source of 2 operands, a single operand is a destination operand */
+            src_op = is_second ? first_op : second_op;
+            dest_op = is_second ? second_op : first_op;
 
-                /* encode first word of the command to memory and increase ic by the number of additional words */
-                write_to_instructions_memory(build_first_word(instruction_index, is_first, is_second, first_operand_addr_method, second_operand_addr_method));
-                ic += cmd_calc_num_additive_words(is_first, is_second, first_operand_addr_method, second_operand_addr_method);
+            /* If addressing methods are valid for this specific command */
+            if ((command->src_methods & METHOD_BIT(src_op.method)) && (command->dest_methods & METHOD_BIT(dest_op.method))) {
+
+                /* record the instruction, its words are encoded when the addresses of the labels are known */
+                instr = add_instruction(&ctx->instructions);
+                instr->opcode = instruction_index;
+                instr->address = ctx->ic;
+                instr->line_num = line_num;
+                instr->src = src_op;
+                instr->dest = dest_op;
+                if (is_second)
+                    reference_operand_label(ctx, tokens, first_operand, &instr->src);
+                if (is_first)
+                    reference_operand_label(ctx, tokens, is_second ? second_operand : first_operand, &instr->dest);
+                ctx->ic += instruction_length(instr);
             }
 
             else {
-                set_error("COMMAND_INVALID_OPERANDS_METHODS");
+                set_error(ctx, ERR_COMMAND_INVALID_OPERANDS_METHODS);
                 return ERROR;
             }
         } else {
-            set_error("COMMAND_INVALID_NUMBER_OF_OPERANDS");
+            set_error(ctx, ERR_COMMAND_INVALID_NUMBER_OF_OPERANDS);
             return ERROR;
         }
     }
@@ -238,39 +314,37 @@ status command_handler(int instruction_index, char *line) {
 /**
  * @brief function which handles the directive instruction ".data" and add values to data memory
  *
- * @param line string which represents the line
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operands
  * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
  */
-status data_directive_handler(char *line) {
+status data_directive_handler(assembler_ctx *ctx, token_list *tokens, int first) {
     bool number_exist = FALSE;
     bool comma_sep_exist = FALSE;
-    char token[20];
-
-    while (!is_end_of_line(line)) {
-        line = copy_next_li_word(token, line);
+    token *tok;
+    int i;
 
-        /* Not an empty token */
-        if (strlen(token) > 0) {
-            if (!number_exist) {         /* if there wasn't a number before */
-                if (!is_number(token)) { /* then the token must be a number */
-                    set_error("DATA_EXPECTED_NUM");
-                    return ERROR;
-                } else {
-                    number_exist = TRUE;                   /* A valid number was inputted */
-                    comma_sep_exist = FALSE;               /* Resetting comma (now it is needed) */
-                    write_num_to_data_memory(atoi(token)); /* encoding number to data */
-                }
-            } else if (*token != ',') { /* If there was a number, now a comma is needed */
-                set_error("DATA_EXPECTED_COMMA_AFTER_NUM");
+    for (i = first; (tok = read_token(ctx, tokens, i)) != NULL; i++) {
+        if (!number_exist) {                  /* if there wasn't a number before */
+            if (tok->kind != TOKEN_NUMBER) { /* then the token must be a number */
+                set_error(ctx, ERR_DATA_EXPECTED_NUM);
                 return ERROR;
-            } else { /* If there was a comma, it should be only once (comma should be false) */
-                if (comma_sep_exist) {
-                    set_error("DATA_COMMAS_IN_A_ROW");
-                    return ERROR;
-                } else {
-                    comma_sep_exist = TRUE;
-                    number_exist = FALSE;
-                }
+            } else {
+                number_exist = TRUE;                        /* A valid number was inputted */
+                comma_sep_exist = FALSE;                    /* Resetting comma (now it is needed) */
+                write_num_to_data_memory(ctx, tok->value); /* encoding number to data */
+            }
+        } else if (tok->kind != TOKEN_COMMA) { /* If there was a number, now a comma is needed */
+            set_error(ctx, ERR_DATA_EXPECTED_COMMA_AFTER_NUM);
+            return ERROR;
+        } else { /* If there was a comma, it should be only once (comma should be false) */
+            if (comma_sep_exist) {
+                set_error(ctx, ERR_DATA_COMMAS_IN_A_ROW);
+                return ERROR;
+            } else {
+                comma_sep_exist = TRUE;
+                number_exist = FALSE;
             }
         }
     }
@@ -278,31 +352,74 @@ status data_directive_handler(char *line) {
     return NO_ERROR;
 }
 
+/**
+ * @brief function which reads a string operand (which may be made of several tokens), and marks its last token.
+ *
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operand
+ * @return int index of the token after the operand
+ */
+static int read_string_operand(assembler_ctx *ctx, token_list *tokens, int first) {
+    int end = string_end(tokens, first);
+
+    if (end > first)
+        read_token(ctx, tokens, end - 1);
+    return end;
+}
+
+/**
+ * @brief function which writes a valid string operand to data memory, each letter is filling a 'word' in the memory.
+ * the quotation marks are not written, and the string is closed with a null word.
+ *
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the string
+ * @param end index of the token after the string
+ */
+static void write_string_operand(assembler_ctx *ctx, token_list *tokens, int first, int end) {
+    char *text;
+    int i, length;
+
+    for (i = first; i < end; i++) {
+        text = TOKEN_TEXT(tokens, i);
+        length = tokens->items[i].length;
+
+        /* "Cutting" quotation marks */
+        if (i == first) {
+            text++;
+            length--;
+        }
+        if (i == end - 1)
+            length--;
+        write_string_to_data_memory(ctx, text, length);
+    }
+    write_num_to_data_memory(ctx, '\0'); /* close string */
+}
+
 /**
  * @brief function which handles the directive instruction ".string" and add values to data memory.
  * each letter is filling a 'word' in the memory.
  *
- * @param line string which represents the line
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operands
  * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
  */
-status string_directive_handler(char *line) {
-    char token[MAX_LINE_LENGTH];
+status string_directive_handler(assembler_ctx *ctx, token_list *tokens, int first) {
+    int end = read_string_operand(ctx, tokens, first);
 
-    line = next_token_string(token, line);
-    if (!is_end_of_line(token) && is_string(token)) { /* If token exists and it's a valid string */
-        line = skip_spaces(line);
+    if (is_string_operand(tokens, first, end)) { /* If token exists and it's a valid string */
         /* If there's no additional token */
-        if (is_end_of_line(line)) {
-            /* "Cutting" quotation marks and encoding it to data */
-            token[strlen(token) - 1] = '\0';
-            write_string_to_data_memory(token + 1);
+        if (end == tokens->count) {
+            write_string_operand(ctx, tokens, first, end);
         } else {
             /* There's another token */
-            set_error("STRING_TOO_MANY_OPERANDS");
+            set_error(ctx, ERR_STRING_TOO_MANY_OPERANDS);
             return ERROR;
         }
     } else {
-        set_error("STRING_OPERAND_NOT_VALID");
+        set_error(ctx, ERR_STRING_OPERAND_NOT_VALID);
         return ERROR;
     }
 
@@ -313,277 +430,180 @@ status string_directive_handler(char *line) {
  * @brief function which handles the directive instruction ".struct" and add values to data memory.
  * the values are number and a string.
  *
- * @param line string which represents the line
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operands
  * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
  */
-status struct_directive_handler(char *line) {
-    char token[MAX_LINE_LENGTH];
-    /* Getting the first token into token array in the line above */
-    line = copy_next_li_word(token, line);
+status struct_directive_handler(assembler_ctx *ctx, token_list *tokens, int first) {
+    token *tok = read_token(ctx, tokens, first);
+    int end;
 
     /* First token must be a number */
-    if (!is_end_of_line(token) && is_number(token)) {
-        write_num_to_data_memory(atoi(token));
-        line = copy_next_li_word(token, line); /* Get next token */
+    if (tok != NULL && tok->kind == TOKEN_NUMBER) {
+        write_num_to_data_memory(ctx, tok->value);
+        tok = read_token(ctx, tokens, first + 1); /* Get next token */
 
         /* There must be a comma between .struct operands */
-        if (!is_end_of_line(token) && *token == ',') {
-            line = next_token_string(token, line); /* Get next token (second operand) */
-            if (!is_end_of_line(token)) {          /* There's a second operand */
-                if (is_string(token)) {
-                    token[strlen(token) - 1] = '\0';
-                    write_string_to_data_memory(token + 1);
+        if (tok != NULL && tok->kind == TOKEN_COMMA) {
+            end = read_string_operand(ctx, tokens, first + 2); /* Get next token (second operand) */
+            if (end > first + 2) {                              /* There's a second operand */
+                if (is_string_operand(tokens, first + 2, end)) {
+                    write_string_operand(ctx, tokens, first + 2, end);
                 } else {
-                    set_error("STRUCT_INVALID_STRING");
+                    set_error(ctx, ERR_STRUCT_INVALID_STRING);
                     return ERROR;
                 }
             } else {
-                set_error("STRUCT_EXPECTED_STRING");
+                set_error(ctx, ERR_STRUCT_EXPECTED_STRING);
                 return ERROR;
             }
         } else {
-            set_error("EXPECTED_COMMA_BETWEEN_OPERANDS");
+            set_error(ctx, ERR_EXPECTED_COMMA_BETWEEN_OPERANDS);
             return ERROR;
         }
     } else {
-        set_error("STRUCT_INVALID_NUM");
+        set_error(ctx, ERR_STRUCT_INVALID_NUM);
         return ERROR;
     }
-    if (!is_end_of_line(copy_next_li_word(token, line))) {
-        set_error("STRUCT_TOO_MANY_OPERANDS");
+    if (read_token(ctx, tokens, end) != NULL) {
+        set_error(ctx, ERR_STRUCT_TOO_MANY_OPERANDS);
         return ERROR;
     }
 
     return NO_ERROR;
 }
 
+/**
+ * @brief function which handles the directive instruction ".entry".
+ * the label may be defined later in the code, so it's recorded as a fixup which is resolved in stage 2.
+ *
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operand
+ * @param line_num the number of the line in code
+ * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
+ */
+status entry_directive_handler(assembler_ctx *ctx, token_list *tokens, int first, int line_num) {
+    int length = TOKENS_LENGTH(tokens, first, word_end(tokens, first)); /* the required label is the next word */
+    int label_id = NOT_FOUND;
+    read_token(ctx, tokens, first);
+
+    /* A name which is too long can't be a label, it will be reported as a missing label in stage 2 */
+    if (length <= LABEL_MAX_LEN)
+        label_id = reference_label(&ctx->symbols_tbl, TOKEN_TEXT(tokens, first), length);
+
+    add_fixup(&ctx->fixups, label_id, line_num);
+    return NO_ERROR;
+}
+
 /**
  * @brief function which handles the directive instruction ".extern".
  *
- * @param line string which represents the line
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param first index of the first token of the operand
  * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
  */
-status extern_directive_handler(char *line) {
-    char token[LABEL_MAX_LEN]; /* This will hold the required label */
-    copy_word(token, line);    /* Getting the next token */
+status extern_directive_handler(assembler_ctx *ctx, token_list *tokens, int first) {
+    int end = word_end(tokens, first); /* the required label is the next word */
+    char *name;
+    int length;
 
-    if (is_end_of_line(token)) {
-        set_error("EXTERN_NO_LABEL");
+    if (read_token(ctx, tokens, first) == NULL) {
+        set_error(ctx, ERR_EXTERN_NO_LABEL);
         return ERROR;
     }
+    name = TOKEN_TEXT(tokens, first);
+    length = TOKENS_LENGTH(tokens, first, end);
 
     /* The token should be a label (without a colon) */
-    if (!is_label(token, FALSE)) {
-        set_error("EXTERN_INVALID_LABEL");
+    if (!is_label(ctx, name, length, FALSE)) {
+        set_error(ctx, ERR_EXTERN_INVALID_LABEL);
         return ERROR;
     }
 
-    line = next_word(line);
-    if (!is_end_of_line(line)) {
-        set_error("EXTERN_TOO_MANY_OPERANDS");
+    if (end < tokens->count) {
+        set_error(ctx, ERR_EXTERN_TOO_MANY_OPERANDS);
         return ERROR;
     }
 
     /* Trying to add the label to the symbols table */
-    if (insert_label(&symbols_tbl, token, FALSE, TRUE) == NULL)
+    if (insert_label(ctx, name, length, SECTION_EXTERN, 0) == NULL)
         return ERROR;
 
     return NO_ERROR;
 }
 
 /**
- * @brief Get the addr method of a given operand,
+ * @brief parses a given operand: gets its addressing method, and the value of an immediate, a register or a
+ * struct field. the label of the operand is referenced only when the instruction is valid.
  *
- * @param operand
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param index index of the token of the operand
+ * @param op the operand to fill
  * @return the addressing methos of the operand. if not found return NOT_FOUND.
  */
-int get_addr_method(char *operand) {
+int parse_operand(assembler_ctx *ctx, token_list *tokens, int index, operand *op) {
+    char *text = TOKEN_TEXT(tokens, index);
+    int length = tokens->items[index].length;
     char *struct_field; /* When determining if it's a .struct directive, this will hold the part after the dot */
+    bool is_struct_label;
 
-    if (is_end_of_line(operand))
-        return NOT_FOUND;
+    op->value = 0;
+    op->label_id = NOT_FOUND;
 
     /* Immediate addressing method check */
-    if (*operand == '#') { /* First character is '#' */
-        operand++;
-        if (is_number(operand))
-            return ADDR_IMMEDIATE;
+    if (*text == '#') { /* First character is '#' */
+        if (tokens->items[index].kind == TOKEN_IMMEDIATE) {
+            op->value = tokens->items[index].value; /* The immediate number was parsed by the lexer */
+            return op->method = ADDR_IMMEDIATE;
+        }
     }
 
     /* Register addressing method check */
-    else if (is_register(operand))
-        return ADDR_REGISTER;
+    else if (is_register(text, length)) {
+        op->value = text[1] - '0'; /* Getting the register's number */
+        return op->method = ADDR_REGISTER;
+    }
 
     /* Direct addressing method check */
-    else if (is_label(operand, FALSE) && strchr(operand, '.') == NULL) { /* Checking if it's a label when there shouldn't be a colon (:) at the end */
-        return ADDR_DIRECT;
+    else if (is_label(ctx, text, length, FALSE) && memchr(text, '.', length) == NULL) { /* Checking if it's a label when there shouldn't be a colon (:) at the end */
+        return op->method = ADDR_DIRECT;
     }
 
     /*----- Struct addressing method check -----*/
-    else if (is_label(strtok(operand, "."), FALSE)) { /* Splitting by dot character */
-        struct_field = strtok(NULL, "");              /* Getting the rest of the string */
-
-        /* After the dot there should be '1' or '2' */
-        if (strlen(struct_field) == 1 && (*struct_field == '1' || *struct_field == '2'))
-            return ADDR_STRUCT;
-    }
-
-    set_error("COMMAND_INVALID_METHOD");
-    return NOT_FOUND;
-}
-
-/**
- * @brief a function which returns the true if the command method is valid according to given methods
- *
- * @param type the command type
- * @param first_method the first addressing method
- * @param second_method the second addressing method
- * @return true if valid, false if invalid.
- */
-bool command_accept_methods(int type, int first_method, int second_method) {
-    switch (type) {
-    /* SRC: 0,1,2,3.  DEST: 1,2,3. */
-    case MOV:
-    case ADD:
-    case SUB:
-        return (first_method == ADDR_IMMEDIATE ||
-                first_method == ADDR_DIRECT ||
-                first_method == ADDR_STRUCT ||
-                first_method == ADDR_REGISTER) &&
-               (second_method == ADDR_DIRECT ||
-                second_method == ADDR_STRUCT ||
-                second_method == ADDR_REGISTER);
-
-    /* SRC: 1,2.  DEST: 1,2,3. */
-    case LEA:
-        return (first_method == ADDR_DIRECT ||
-                first_method == ADDR_STRUCT) &&
-               (second_method == ADDR_DIRECT ||
-                second_method == ADDR_STRUCT ||
-                second_method == ADDR_REGISTER);
-
-    /* SRC: NONE.  DEST: 1,2,3. */
-    case NOT:
-    case CLR:
-    case INC:
-    case DEC:
-    case JMP:
-    case BNE:
-    case GET:
-    case JSR:
-        return first_method == ADDR_DIRECT ||
-               first_method == ADDR_STRUCT ||
-               first_method == ADDR_REGISTER;
-
-    /* SRC: NO_LIMIT.  DEST: NO_LIMIT. */
-    case PRN:
-    case CMP:
-    case RTS:
-    case HLT:
-        return TRUE;
-    }
-
-    return FALSE;
-}
-
-/**
- * @brief a function which returns the true if the command method is valid according to the number of given operands
- *
- * @param type type of the operation
- * @param first true if first operand exists, otherwise false.
- * @param second true if second operand exists, otherwise false.
- * @return true if valid, false if invalid.
- */
-bool command_accept_num_operands(int type, bool first, bool second) {
-    switch (type) {
-    /* These opcodes must receive 2 operands */
-    case MOV:
-    case CMP:
-    case ADD:
-    case SUB:
-    case LEA:
-        return first && second;
-
-    /* These opcodes must only receive 1 operand */
-    case NOT:
-    case CLR:
-    case INC:
-    case DEC:
-    case JMP:
-    case BNE:
-    case GET:
-    case PRN:
-    case JSR:
-        return first && !second;
-
-    /* These opcodes can't have any operand */
-    case RTS:
-    case HLT:
-        return !first && !second;
+    else if ((struct_field = (char *)memchr(text, '.', length)) != NULL) { /* Splitting by dot character */
+        is_struct_label = is_label(ctx, text, struct_field - text, FALSE);
+        struct_field++; /* getting the rest of the operand */
+
+        /* Before the dot there should be a label, and after it '1' or '2' */
+        if (is_struct_label && text + length - struct_field == 1 && (*struct_field == '1' || *struct_field == '2')) {
+            op->value = *struct_field - '0';
+            return op->method = ADDR_STRUCT;
+        }
     }
-    return FALSE;
-}
 
-/**
- * @brief function which returns the number of words according to addresing method requires
- *
- * @param method the addressing method
- * @return int number of words
- */
-int num_words_per_addr_method(int method) {
-    /* Struct addressing method requires two additional words */
-    if (method == ADDR_STRUCT)
-        return 2;
-    return 1;
+    set_error(ctx, ERR_COMMAND_INVALID_METHOD);
+    return op->method = NOT_FOUND;
 }
 
 /**
- * @brief Calculates number of additive words accurdong to a certain command
- * @return unsigned int which represents the first word in the instructions memory.
- */
-int cmd_calc_num_additive_words(int is_first, int is_second, int first_method, int second_method) {
-    int count = 0;
-    if (is_first)
-        count += num_words_per_addr_method(first_method);
-    if (is_second)
-        count += num_words_per_addr_method(second_method);
-
-    /* If both methods are register, they will share the same additional word */
-    if (is_first && is_second && first_method == ADDR_REGISTER && second_method == ADDR_REGISTER)
-        count--;
-
-    return count;
-}
-
-/* This function encodes the first word of the command */
-/**
- * @brief function which generates a the first word of command with given params
+ * @brief references the label of a direct or a struct operand in the symbols table.
+ * the label may be defined later in the code, its address is encoded in stage 2.
  *
- * @param type the type of the command
- * @return unsigned int which represents the first word in the instructions memory.
+ * @param ctx the assembler context
+ * @param tokens the tokens of the line
+ * @param index index of the token of the operand
+ * @param op the parsed operand
  */
-unsigned int build_first_word(int type, int is_first, int is_second, int first_method, int second_method) {
-    unsigned int word = 0;
-
-    /* Inserting the opcode */
-    word = type;
-
-    word <<= BITS_IN_METHOD; /* Leave space for first addressing method */
-
-    /* If there are two operands, insert the first */
-    if (is_first && is_second)
-        word |= first_method;
-
-    word <<= BITS_IN_METHOD; /* Leave space for second addressing method */
-
-    /* If there are two operands, insert the second. */
-    if (is_first && is_second)
-        word |= second_method;
-    /* If not, insert the first one (a single operand is a destination operand). */
-    else if (is_first)
-        word |= first_method;
-
-    word = inject_ARE(word, ABSOLUTE); /* Insert A/R/E mode to the word */
-
-    return word;
+void reference_operand_label(assembler_ctx *ctx, token_list *tokens, int index, operand *op) {
+    char *text = TOKEN_TEXT(tokens, index);
+    int length = tokens->items[index].length;
+
+    if (op->method == ADDR_STRUCT) /* The label is before the dot */
+        length = (char *)memchr(text, '.', length) - text;
+    if (op->method == ADDR_DIRECT || op->method == ADDR_STRUCT)
+        op->label_id = reference_label(&ctx->symbols_tbl, text, length);
 }
@@ -2,24 +2,26 @@
 #define STAGE_1_H
 
 #include "global.h"
+#include "lexer.h"
 #include "text_engine.h"
-#include "labels_linked_list.h"
+#include "symbols_table.h"
+#include "fixup_list.h"
+#include "instruction_list.h"
+#include "parallel_stage_1.h"
 #include <stdio.h>
 
 /* Prototypes */
-void stage_1(FILE *curr_file, char *filename);
-status read_line_stage_1(char *line, int line_num);
-status directive_handler(int instruction_index, char* line);
-status command_handler(int instruction_index, char* line);
-status data_directive_handler(char *line);
-status string_directive_handler(char *line);
-status struct_directive_handler(char *line);
-status extern_directive_handler(char *line);
-int cmd_calc_num_additive_words(int is_first, int is_second, int first_method, int second_method);
-bool command_accept_num_operands(int type, bool first, bool second);
-bool command_accept_methods(int type, int first_method, int second_method);
-int get_addr_method(char *operand);
-int num_words_per_addr_method(int method);
-unsigned int build_first_word(int type, int is_first, int is_second, int first_method, int second_method);
+void stage_1(assembler_ctx *ctx, text_buffer *source);
+void compile_lines(assembler_ctx *ctx, line_index *lines, char *text, long first, long end);
+status read_line_stage_1(assembler_ctx *ctx, token_list *tokens, int line_num);
+status directive_handler(assembler_ctx *ctx, int instruction_index, token_list *tokens, int first, int line_num);
+status command_handler(assembler_ctx *ctx, int instruction_index, token_list *tokens, int first, int line_num);
+status data_directive_handler(assembler_ctx *ctx, token_list *tokens, int first);
+status string_directive_handler(assembler_ctx *ctx, token_list *tokens, int first);
+status struct_directive_handler(assembler_ctx *ctx, token_list *tokens, int first);
+status entry_directive_handler(assembler_ctx *ctx, token_list *tokens, int first, int line_num);
+status extern_directive_handler(assembler_ctx *ctx, token_list *tokens, int first);
+int parse_operand(assembler_ctx *ctx, token_list *tokens, int index, operand *op);
+void reference_operand_label(assembler_ctx *ctx, token_list *tokens, int index, operand *op);
 
 #endif
@@ -4,120 +4,152 @@
  */
 
 #include "stage_2.h"
+#include "parallel_stage_2.h"
 #include <stdio.h>
 
 /**
  * @brief Function which is managing in high level the second stage.
- * the main purpose of this function is to finish compilation of the .am file and to output upto 3 files
+ * the main purpose of this function is to finish compilation of the code which was parsed in stage 1, by encoding
+ * the instructions with the addresses of their labels and resolving the .entry directives, and to output upto 3 files
  * .ob file, .ext file, .ent file which represents the 32 base code files.
  *
- * @param curr_file the current file to compile. it's the .am file.
- * @param filename the file name w/o its extension.
+ * @param ctx the assembler context
+ * @param out the result to store the content of the output files in
  */
-void stage_2(FILE *curr_file, char *filename) {
-    char temp_line[MAX_LINE_LENGTH]; /* temporary string for storing line, read from file */
-    int line_count = 1;
-    ic = 0;
-
+void stage_2(assembler_ctx *ctx, assembly_result *out) {
     /* title for stage 2 */
-    printf("\n __________________________\n");
-    printf("|         STAGE 2#         |\n");
-    printf(" ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
+    print_log(ctx, "\n __________________________\n");
+    print_log(ctx, "|         STAGE 2#         |\n");
+    print_log(ctx, " ‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾‾\n");
 
-    printf("* Wrapping it up...\n");
-    /* Read lines until end of file */
-    while (fgets(temp_line, MAX_LINE_LENGTH, curr_file) != NULL) {
-        set_error("NO_ERROR");
-        read_line_stage_2(temp_line, line_count);
+    print_log(ctx, "* Wrapping it up...\n");
+    resolve_labels(ctx);
 
-        line_count++;
-    }
+    /* the addresses of the object are written as 2 digits of base 32, so a larger program (which can only be
+     * compiled without a memory size) has no output */
+    if (!ctx->error_occured_flag && ctx->load_base + ctx->ic + ctx->dc > MEMORY_SIZE)
+        throw_err(ctx, ERR_MEMORY_OVERFLOW, 0);
 
     /*create output files only if there were no errors at the process*/
-    if (!error_occured_flag) {
-        generate_output_files(filename);
+    if (!ctx->error_occured_flag) {
+        generate_output(ctx, out);
     }
 
-    printf("* Finished stage 2.");
-
-    free_labels(&symbols_tbl);
-    ext_free_list(&ext_list);
+    print_log(ctx, "* Finished stage 2.");
 }
 
 /**
- * @brief Function which gets a line of code and a number of the line,
- * checks if the line is a directive instruction or command instruction and gets another details.
+ * @brief Function which encodes the instructions which were recorded in stage 1, and resolves the .entry directives,
+ * by order of lines. an error is reported once per line, as the line is completed.
+ * the instructions are encoded at once (by several threads if the context has them), so the labels of the instructions
+ * are checked again by order of lines only if some of them aren't defined.
  *
- * @param line string which reperesents a line of code
- * @param line_num  the number of the line in code
- * @return status returns the status of success if there were errors while compiling the code.
+ * @param ctx the assembler context
  */
-status read_line_stage_2(char *line, int line_num) {
-    int instruction_index;
-    char curr_word[MAX_LINE_LENGTH]; /* will hold current token as needed */
-
-    /* Ignore line if it's blank or a comment */
-    if (is_ignore_line(line))
-        return NO_ERROR; /* skip to next line */
-
-    line = skip_spaces(line); /* Proceeding to first non-blank character */
-    if (is_end_of_line(line))
-        return NO_ERROR; /* a blank line is not an error */
-
-    copy_word(curr_word, line);
-    if (is_label(curr_word, TRUE)) { /* If it's a label, skip it */
-        line = next_word(line);
-        copy_word(curr_word, line);
-    }
-
-    /* We need to handle only .entry directive */
-    if ((instruction_index = find_directive(curr_word)) != NOT_FOUND) {
-        line = next_word(line);
-        if (instruction_index == ENTRY) {
-            copy_word(curr_word, line);
-            set_label_to_entry(symbols_tbl, curr_word); /* Creating an entry for the symbol */
+void resolve_labels(assembler_ctx *ctx) {
+    instruction *instr = ctx->instructions.items;
+    instruction *instr_end = instr + ctx->instructions.count;
+    fixup *entry = ctx->fixups.items;
+    fixup *entry_end = entry + ctx->fixups.count;
+    int line_num = 0, next_line;
+
+    if (encode_instructions(ctx) == 0)
+        instr = instr_end; /* all the labels of the instructions are defined */
+
+    begin_line(ctx, NULL);
+    while (instr < instr_end || entry < entry_end) {
+        /* both lists are ordered by lines, and are merged by their lines */
+        if (entry == entry_end || (instr < instr_end && instr->line_num < entry->line_num))
+            next_line = instr->line_num;
+        else
+            next_line = entry->line_num;
+
+        /* print the error of the previous line (if occured) when moving to the next line */
+        if (next_line != line_num) {
+            report_error(ctx, line_num);
+            begin_line(ctx, NULL);
+            line_num = next_line;
         }
-    }
 
-    /* Encoding command's additional words */
-    else if ((instruction_index = find_command(curr_word)) != NOT_FOUND) {
-        line = next_word(line);
-        command_handler_stage_2(instruction_index, line);
+        if (instr < instr_end && instr->line_num == line_num) {
+            if (!is_operand_resolved(&ctx->symbols_tbl, &instr->src) || !is_operand_resolved(&ctx->symbols_tbl, &instr->dest))
+                set_error(ctx, ERR_COMMAND_LABEL_DOES_NOT_EXIST);
+            instr++;
+        } else
+            set_label_to_entry(ctx, (entry++)->label_id); /* Creating an entry for the symbol */
     }
+    report_error(ctx, line_num);
+}
 
-    /* if error occured in commannd handler or in directive handler */
-    if (print_error(line_num))
-        return ERROR;
-
-    return NO_ERROR;
+/**
+ * @param tbl the symbols table
+ * @param op an operand of an instruction
+ * @return true if the operand has no label, or its label is defined
+ */
+bool is_operand_resolved(symbols_table *tbl, operand *op) {
+    return op->label_id == NOT_FOUND || tbl->labels[op->label_id].defined;
 }
 
 /**
- * @brief function which gets a name of the working file and generates up to 3 files
+ * @brief function which generates the content of up to 3 files
  * .ext file will be generated only if there were .extern instructions in the code
  * .ent file will be generated only if there were .entry instructions in the code
  * .ob file will always be generated according to the table that was generated in stage 1, the file will represent the .as code in 32 base letters.
+ * each file is built in a single buffer, so it can be written at once.
  *
- * @param filename file name of the source code
- * @return int
+ * @param ctx the assembler context
+ * @param out the result to store the content of the files in
  */
-status generate_output_files(char *filename) {
-    FILE *file;
+void generate_output(assembler_ctx *ctx, assembly_result *out) {
+    out->has_output = TRUE;
+    write_output_ob(ctx, &out->object);
 
-    file = create_file(filename, FILE_OBJECT); /* generate .ob file */
-    write_output_ob(file);
+    out->has_entries = ctx->entry_exists;
+    if (ctx->entry_exists)
+        write_output_entry(ctx, &out->entries);
 
-    if (entry_exists) {
-        file = create_file(filename, FILE_ENTRY); /* generate .ent file */
-        write_output_entry(file);
-    }
+    out->has_externals = ctx->extern_exists;
+    if (ctx->extern_exists)
+        write_output_extern(ctx, &out->externals);
+}
 
-    if (extern_exists) {
-        file = create_file(filename, FILE_EXTERN); /* generate .ext file */
-        write_output_extern(file);
-    }
+/**
+ * @brief appends a line of 2 words encoded in base 32 ("xx\tyy\n") to the output buffer
+ *
+ * @param out the output buffer, which must have room for the line
+ * @param left the word in the left column
+ * @param right the word in the right column
+ */
+static void put_words_line(text_buffer *out, unsigned int left, unsigned int right) {
+    char *dest = out->data + out->length;
+
+    encode_base_32(left, dest);
+    dest[BASE32_WORD_LENGTH] = '\t';
+    encode_base_32(right, dest + BASE32_WORD_LENGTH + 1);
+    dest[OUTPUT_LINE_LENGTH - 1] = '\n';
+    out->length += OUTPUT_LINE_LENGTH;
+}
 
-    return NO_ERROR;
+/**
+ * @brief appends a line of a label name and its address encoded in base 32 ("name\txx\n") to the output buffer
+ *
+ * @param out the output buffer
+ * @param name the name of the label
+ * @param address the address of the label
+ */
+static void put_label_line(text_buffer *out, char *name, unsigned int address) {
+    long name_length = strlen(name);
+    char *dest;
+
+    text_buffer_reserve(out, name_length + BASE32_WORD_LENGTH + 2);
+    dest = out->data + out->length;
+
+    memcpy(dest, name, name_length);
+    dest += name_length;
+    *dest++ = '\t';
+    encode_base_32(address, dest);
+    dest[BASE32_WORD_LENGTH] = '\n';
+    out->length += name_length + BASE32_WORD_LENGTH + 2;
 }
 
 /* This function writes the .ob file output.
@@ -130,44 +162,26 @@ status generate_output_files(char *filename) {
  * left column is the address
  * right column is the word in memory
  *
- * @param fd the file to write to. which is the .ob file.
+ * @param ctx the assembler context
+ * @param out buffer to build the content of the .ob file in
  */
-void write_output_ob(FILE *fd) {
-    unsigned int address = IC_INIT_ADDR;
+void write_output_ob(assembler_ctx *ctx, text_buffer *out) {
+    unsigned int address = ctx->load_base;
     int i;
-    char *slice1;
-    char *slice2;
-
-    slice1 = convert_to_base_32(ic);
-    slice2 = convert_to_base_32(dc);
 
-    fprintf(fd, "%s\t%s\n\n", slice1, slice2); /* First line */
-    free(slice1);
-    free(slice2);
+    /* the size of the file is known in advance: a header line, an empty line, and a line per word */
+    out->length = 0;
+    text_buffer_reserve(out, (long)OUTPUT_LINE_LENGTH * (ctx->ic + ctx->dc + 1) + 1);
 
-    for (i = 0; i < ic; address++, i++) /* Instructions memory */
-    {
-        slice1 = convert_to_base_32(address);
-        slice2 = convert_to_base_32(instr_memory[i]);
+    put_words_line(out, ctx->ic, ctx->dc); /* First line */
+    out->data[out->length++] = '\n';
 
-        fprintf(fd, "%s\t%s\n", slice1, slice2);
-
-        free(slice1);
-        free(slice2);
-    }
+    for (i = 0; i < ctx->ic; address++, i++) /* Instructions memory */
+        put_words_line(out, address, ctx->instr_memory.words[i]);
 
-    for (i = 0; i < dc; address++, i++) /* Data memory */
-    {
-        slice1 = convert_to_base_32(address);
-        slice2 = convert_to_base_32(data_memory[i]);
-
-        fprintf(fd, "%s\t%s\n", slice1, slice2);
-
-        free(slice1);
-        free(slice2);
-    }
-
-    fclose(fd);
+    for (i = 0; i < ctx->dc; address++, i++) /* Data memory */
+        put_words_line(out, address, ctx->data_memory.words[i]);
+    out->data[out->length] = '\0';
 }
 
 /**
@@ -175,22 +189,21 @@ void write_output_ob(FILE *fd) {
  * left column is the label name
  * right column is the address of the label in memory.
  *
- * @param fd the file to write to. which is the .ent file.
+ * @param ctx the assembler context
+ * @param out buffer to build the content of the .ent file in
  */
-void write_output_entry(FILE *fd) {
-    char *base32_address;
-
-    label_ptr label = symbols_tbl;
-    /* Go through symbols table and print only symbols that have an entry */
-    while (label) {
-        if (label->entry) {
-            base32_address = convert_to_base_32(label->address);
-            fprintf(fd, "%s\t%s\n", label->name, base32_address);
-            free(base32_address);
-        }
-        label = label->next;
+void write_output_entry(assembler_ctx *ctx, text_buffer *out) {
+    int i;
+    label_ptr label;
+
+    out->length = 0;
+    /* Go through symbols table (by order of definition) and print only symbols that have an entry */
+    for (i = 0; i < ctx->symbols_tbl.num_defined; i++) {
+        label = &ctx->symbols_tbl.labels[ctx->symbols_tbl.defined[i]];
+        if (label->entry)
+            put_label_line(out, LABEL_NAME(&ctx->symbols_tbl, label), label_address(&ctx->symbols_tbl, label));
     }
-    fclose(fd);
+    out->data[out->length] = '\0';
 }
 
 /**
@@ -198,122 +211,58 @@ void write_output_entry(FILE *fd) {
  * left column is the label name
  * right column is the address of the external label in memory.
  *
- * @param fd the file to write to. which is the .ent file.
+ * @param ctx the assembler context
+ * @param out buffer to build the content of the .ext file in
  */
-void write_output_extern(FILE *fd) {
-    char *base32_address;
-    ext_ptr node;
-    node = ext_list;
-
-    /* Going through external circular linked list and pulling out values */
-    do {
-        base32_address = convert_to_base_32(node->address);
-        fprintf(fd, "%s\t%s\n", node->name, base32_address);
-        free(base32_address);
-        node = node->next;
-    } while (node != ext_list);
-    fclose(fd);
+void write_output_extern(assembler_ctx *ctx, text_buffer *out) {
+    extern_ref *ref = ctx->externs.items;
+    extern_ref *end = ref + ctx->externs.count;
+
+    out->length = 0;
+    /* Going through the references by order of their addresses (an external label may be declared and never used) */
+    for (; ref < end; ref++)
+        put_label_line(out, LABEL_NAME(&ctx->symbols_tbl, &ctx->symbols_tbl.labels[ref->label_id]), ref->address + ctx->load_base);
+    out->data[out->length] = '\0';
 }
 
 /**
- * @brief function which checks if source and destination operands exist by opcode
+ * @brief function which encodes the words of an instruction to the instructions memory
  *
- * @param type type of the command
- * @param is_src is source
- * @param is_dest  is destination
+ * @param slice the slice of the instruction
+ * @param instr the instruction
  */
-void check_operands_exist(int type, bool *is_src, bool *is_dest) {
-    switch (type) {
-    case MOV:
-    case CMP:
-    case ADD:
-    case SUB:
-    case LEA:
-        *is_src = TRUE;
-        *is_dest = TRUE;
-        break;
+void encode_instruction(instruction_slice *slice, instruction *instr) {
+    unsigned int address = instr->address;
 
-    case NOT:
-    case CLR:
-    case INC:
-    case DEC:
-    case JMP:
-    case BNE:
-    case GET:
-    case PRN:
-    case JSR:
-        *is_src = FALSE;
-        *is_dest = TRUE;
-        break;
+    slice->memory[address++] = build_first_word(instr);
 
-    case RTS:
-    case HLT:
-        *is_src = FALSE;
-        *is_dest = FALSE;
+    /* There's a special case where 2 register operands share the same additional word */
+    if (instr->src.method == ADDR_REGISTER && instr->dest.method == ADDR_REGISTER) {
+        slice->memory[address] = build_register_word(FALSE, instr->src.value) | build_register_word(TRUE, instr->dest.value);
+        return;
     }
+    address = encode_operand(slice, &instr->src, FALSE, address);
+    encode_operand(slice, &instr->dest, TRUE, address);
 }
 
 /**
- * @brief function which manages the commands in the second stage, finishing the last words addressing.
+ * @brief function which generates the first word of an instruction
  *
- * @param type type of command
- * @param line string which represents a line.
- * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
+ * @param instr the instruction
+ * @return unsigned int which represents the first word in the instructions memory.
  */
-status command_handler_stage_2(int type, char *line) {
-    char first_op[MAX_LINE_LENGTH];
-    char second_op[MAX_LINE_LENGTH];
-    char *src = first_op, *dest = second_op;
-
-    bool is_src = FALSE, is_dest = FALSE;
-    int src_method = ADDR_UNKNOWN, dest_method = ADDR_UNKNOWN;
-
-    check_operands_exist(type, &is_src, &is_dest);
-
-    /* Extracting source and destination addressing methods */
-    if (is_src)
-        src_method = extract_bits(instr_memory[ic], 4, 5);
-    if (is_dest)
-        dest_method = extract_bits(instr_memory[ic], 2, 3);
-
-    /* Matching src and dest pointers to the correct operands (first or second or both) */
-    if (is_src || is_dest) {
-        line = copy_next_li_word(first_op, line);
-
-        /* There are 2 operands */
-        if (is_src && is_dest) {
-            line = copy_next_li_word(second_op, line);
-            copy_next_li_word(second_op, line);
-        } else {
-            dest = first_op;
-            src = NULL;
-        }
-    }
+unsigned int build_first_word(instruction *instr) {
+    unsigned int word = instr->opcode; /* Inserting the opcode */
 
-    ic++; /* The first word of the command was already encoded in this IC in the first pass */
-    return write_additional_words(src, dest, is_src, is_dest, src_method, dest_method);
-}
+    word <<= BITS_IN_METHOD; /* Leave space for the source addressing method */
+    if (instr->src.method != ADDR_UNKNOWN)
+        word |= instr->src.method;
 
-/**
- * @brief function which writes the additive words of the opernds to the instructions memory
- *
- * @param src source
- * @param dest destination
- * @param is_src is source exists
- * @param is_dest is destination exists
- * @return NO_ERROR if there were no errors. or ERORR if there were error while this function was running.
- */
-status write_additional_words(char *src, char *dest, bool is_src, bool is_dest, int src_method, int dest_method) {
-    /* There's a special case where 2 register operands share the same additional word */
-    if (is_src && is_dest && src_method == ADDR_REGISTER && dest_method == ADDR_REGISTER) {
-        write_to_instructions_memory(build_register_word(FALSE, src) | build_register_word(TRUE, dest));
-    } else {
-        if (is_src)
-            encode_additional_word(FALSE, src_method, src);
-        if (is_dest)
-            encode_additional_word(TRUE, dest_method, dest);
-    }
-    return (status)is_error_exists();
+    word <<= BITS_IN_METHOD; /* Leave space for the destination addressing method */
+    if (instr->dest.method != ADDR_UNKNOWN)
+        word |= instr->dest.method;
+
+    return inject_ARE(word, ABSOLUTE); /* Insert A/R/E mode to the word */
 }
 
 /**
@@ -323,77 +272,69 @@ status write_additional_words(char *src, char *dest, bool is_src, bool is_dest,
  * @param reg register number
  * @return unsigned int  returns the new generated word
  */
-unsigned int build_register_word(bool is_dest, char *reg) {
-
-    /* Getting the register's number */
-    unsigned int word = (unsigned int)atoi(reg + 1);
+unsigned int build_register_word(bool is_dest, int reg) {
+    unsigned int word = (unsigned int)reg;
 
     /* Inserting it to the required bits (by source or destination operand) */
     if (!is_dest)
         word <<= BITS_IN_REGISTER;
-    word = inject_ARE(word, ABSOLUTE);
-    return word;
+    return inject_ARE(word, ABSOLUTE);
 }
 
 /**
- * @brief function which gets a label and writes it to memory
- * @param label the label to write
+ * @brief This function encodes the additional words of an operand to instructions memory
+ *
+ * @param slice the slice of the instruction
+ * @param op the operand
+ * @param is_dest boolean, is it destination
+ * @param address index of the first additional word of the operand
+ * @return unsigned int index of the word after the operand
  */
-void write_label(char *label) {
-    unsigned int word; /* The word to be encoded */
+unsigned int encode_operand(instruction_slice *slice, operand *op, bool is_dest, unsigned int address) {
+    switch (op->method) {
+    case ADDR_IMMEDIATE:
+        slice->memory[address++] = inject_ARE((unsigned int)op->value, ABSOLUTE);
+        break;
 
-    if (is_existing_label(symbols_tbl, label)) {   /* If label exists */
-        word = get_label_addr(symbols_tbl, label); /* Getting label's address */
+    case ADDR_DIRECT:
+        slice->memory[address] = resolve_label_word(slice, op->label_id, address);
+        address++;
+        break;
 
-        if (is_label_external(symbols_tbl, label)) { /* If the label is an external one */
-            /* Adding external label to external list (value should be replaced in this address) */
-            ext_insert_item(&ext_list, label, ic + IC_INIT_ADDR);
-            word = inject_ARE(word, EXTERNAL);
-        } else
-            word = inject_ARE(word, RELOCATABLE); /* If it's not an external label, then it's relocatable */
+    case ADDR_STRUCT: /* The address of the label is the first additional word, and the field is the second */
+        slice->memory[address] = resolve_label_word(slice, op->label_id, address);
+        address++;
+        slice->memory[address++] = inject_ARE((unsigned int)op->value, ABSOLUTE);
+        break;
 
-        write_to_instructions_memory(word); /* Encode word to memory */
-    } else {
-        ic++;
-        set_error("COMMAND_LABEL_DOES_NOT_EXIST");
+    case ADDR_REGISTER:
+        slice->memory[address++] = build_register_word(is_dest, op->value);
+        break;
     }
+    return address;
 }
 
 /**
- * @brief This function encodes an additional word to instructions memory, given the addressing method
+ * @brief function which encodes a word which holds the address of a label.
+ * the symbols table is only read, so the slices can be encoded at the same time.
  *
- * @param is_dest boolean, is it destination
- * @param method addressing method
- * @param operand the operand
+ * @param slice the slice of the instruction, which collects its references to external labels
+ * @param label_id the id of the label
+ * @param address index of the word in the instructions memory
+ * @return unsigned int the word, or an empty word if the label isn't defined (it's counted as unresolved)
  */
-void encode_additional_word(bool is_dest, int method, char *operand) {
-    unsigned int word = 0; /* An empty word */
-    char *temp;
-
-    switch (method) {
-    case ADDR_IMMEDIATE: /* Extracting immediate number */
-        word = (unsigned int)atoi(operand + 1);
-        word = inject_ARE(word, ABSOLUTE);
-        write_to_instructions_memory(word);
-        break;
+unsigned int resolve_label_word(instruction_slice *slice, int label_id, unsigned int address) {
+    label_ptr label = &slice->symbols_tbl->labels[label_id];
 
-    case ADDR_DIRECT:
-        write_label(operand);
-        break;
-
-    case ADDR_STRUCT: /* Before the dot there should be a label, and after it a number */
-        temp = strchr(operand, '.');
-        *temp = '\0';
-
-        write_label(operand); /* Label before dot is the first additional word */
-        *temp++ = '.';
-        word = (unsigned int)atoi(temp);
-        word = inject_ARE(word, ABSOLUTE);
-        write_to_instructions_memory(word); /* The number after the dot is the second */
-        break;
+    if (!label->defined) {
+        slice->num_unresolved++;
+        return 0;
+    }
 
-    case ADDR_REGISTER:
-        word = build_register_word(is_dest, operand);
-        write_to_instructions_memory(word);
+    if (label->section == SECTION_EXTERN) { /* If the label is an external one */
+        /* Adding a reference to the external label (value should be replaced in this address) */
+        add_extern_ref(&slice->externs, label_id, address);
+        return inject_ARE(0, EXTERNAL);
     }
+    return inject_ARE(label_address(slice->symbols_tbl, label), RELOCATABLE); /* If it's not an external label, then it's relocatable */
 }
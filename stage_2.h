@@ -2,23 +2,26 @@
 #define STAGE_2_H
 
 #include "global.h"
-#include "labels_linked_list.h"
+#include "symbols_table.h"
 #include "text_engine.h"
 #include "utils.h"
-#include "external_linked_list.h"
+#include "extern_refs.h"
 #include <stdio.h>
 
-void stage_2(FILE *curr_file, char *filename);
-status read_line_stage_2(char *line, int line_num);
-status command_handler_stage_2(int type, char *line);
-status generate_output_files(char *original);
-void write_output_ob(FILE *fp);
-void write_output_entry(FILE *fp);
-void write_output_extern(FILE *fp);
-void check_operands_exist(int type, bool *is_src, bool *is_dest);
-unsigned int build_register_word(bool is_dest, char *reg);
-status write_additional_words(char *src, char *dest, bool is_src, bool is_dest, int src_method, int dest_method);
-void encode_additional_word(bool is_dest, int method, char *operand);
-void write_label(char *label);
+/* Declarations */
+#define OUTPUT_LINE_LENGTH 6 /* length of a line of 2 words in base 32, incl. the tab and the new line */
+
+void stage_2(assembler_ctx *ctx, assembly_result *out);
+void resolve_labels(assembler_ctx *ctx);
+bool is_operand_resolved(symbols_table *tbl, operand *op);
+void encode_instruction(instruction_slice *slice, instruction *instr);
+unsigned int build_first_word(instruction *instr);
+unsigned int build_register_word(bool is_dest, int reg);
+unsigned int encode_operand(instruction_slice *slice, operand *op, bool is_dest, unsigned int address);
+unsigned int resolve_label_word(instruction_slice *slice, int label_id, unsigned int address);
+void generate_output(assembler_ctx *ctx, assembly_result *out);
+void write_output_ob(assembler_ctx *ctx, text_buffer *out);
+void write_output_entry(assembler_ctx *ctx, text_buffer *out);
+void write_output_extern(assembler_ctx *ctx, text_buffer *out);
 
 #endif
@@ -0,0 +1,229 @@
+/**
+ * @file string_pool.c
+ * @brief this file includes the pool of interned strings of a source: the names of its labels and macros.
+ * each distinct name is stored once, and is referred to by its id (the order of its first appearance), so the tables
+ * which are keyed by names compare ids instead of strings. the pool is indexed by an open-addressing hash table
+ * (linear probing) which stores the hash of each string, and the strings are kept in a single array of characters.
+ * a name map keeps a value (e.g. the id of a label) for each id of the pool.
+ */
+
+#include "string_pool.h"
+
+/* Prototypes */
+static int find_slot(string_pool *pool, const char *str, long length, unsigned long hash);
+static void grow_index(string_pool *pool);
+
+/**
+ * @brief initialize an empty pool
+ *
+ * @param pool the pool to initialize
+ */
+void pool_init(string_pool *pool) {
+    int i;
+
+    pool->length = 0;
+    pool->chars_capacity = POOL_INIT_CHARS;
+    pool->chars = (char *)malloc_w_check(pool->chars_capacity);
+
+    pool->count = 0;
+    pool->capacity = POOL_INIT_STRINGS;
+    pool->offsets = (long *)malloc_w_check(sizeof(long) * pool->capacity);
+    pool->hashes = (unsigned long *)malloc_w_check(sizeof(unsigned long) * pool->capacity);
+
+    pool->num_slots = POOL_INIT_SLOTS;
+    pool->slots = (int *)malloc_w_check(sizeof(int) * pool->num_slots);
+    for (i = 0; i < pool->num_slots; i++)
+        pool->slots[i] = EMPTY_POOL_SLOT;
+}
+
+/**
+ * @brief removes all the strings from the pool, and keeps its memory for the next source
+ *
+ * @param pool the pool to clear
+ */
+void pool_reset(string_pool *pool) {
+    int i;
+
+    pool->length = 0;
+    pool->count = 0;
+    for (i = 0; i < pool->num_slots; i++)
+        pool->slots[i] = EMPTY_POOL_SLOT;
+}
+
+/**
+ * @brief free memory allocation of a given pool
+ *
+ * @param pool the pool to free
+ */
+void pool_free(string_pool *pool) {
+    free(pool->chars);
+    free(pool->offsets);
+    free(pool->hashes);
+    free(pool->slots);
+    pool->chars = NULL;
+    pool->offsets = NULL;
+    pool->hashes = NULL;
+    pool->slots = NULL;
+    pool->length = pool->chars_capacity = 0;
+    pool->count = pool->capacity = pool->num_slots = 0;
+}
+
+/**
+ * @brief finds the slot of a string, or the empty slot where it should be inserted
+ *
+ * @param pool the pool
+ * @param str the string (not null terminated)
+ * @param length the length of the string
+ * @param hash the hash of the string
+ * @return int index of the slot in the hash index
+ */
+static int find_slot(string_pool *pool, const char *str, long length, unsigned long hash) {
+    int mask = pool->num_slots - 1;
+    int i = (int)(hash & mask);
+    char *temp;
+
+    while (pool->slots[i] != EMPTY_POOL_SLOT) {
+        temp = POOL_STRING(pool, pool->slots[i]);
+        if (pool->hashes[pool->slots[i]] == hash && !strncmp(temp, str, length) && temp[length] == '\0')
+            return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * @brief doubles the number of slots in the hash index, and re-inserts all the strings
+ *
+ * @param pool the pool
+ */
+static void grow_index(string_pool *pool) {
+    int i, j, mask;
+
+    free(pool->slots);
+    pool->num_slots *= 2;
+    pool->slots = (int *)malloc_w_check(sizeof(int) * pool->num_slots);
+    for (i = 0; i < pool->num_slots; i++)
+        pool->slots[i] = EMPTY_POOL_SLOT;
+
+    mask = pool->num_slots - 1;
+    for (i = 0; i < pool->count; i++) {
+        j = (int)(pool->hashes[i] & mask);
+        while (pool->slots[j] != EMPTY_POOL_SLOT)
+            j = (j + 1) & mask;
+        pool->slots[j] = i;
+    }
+}
+
+/**
+ * @brief Get the id of a string, the string is added to the pool if it isn't there yet
+ *
+ * @param pool the pool
+ * @param str the string (not null terminated)
+ * @param length the length of the string
+ * @return int the id of the string
+ */
+int intern_string(string_pool *pool, const char *str, long length) {
+    unsigned long hash = hash_span((char *)str, length);
+    int slot = find_slot(pool, str, length, hash);
+
+    if (pool->slots[slot] != EMPTY_POOL_SLOT)
+        return pool->slots[slot];
+
+    /* keep the load factor of the index under a half */
+    if ((pool->count + 1) * 2 > pool->num_slots) {
+        grow_index(pool);
+        slot = find_slot(pool, str, length, hash);
+    }
+
+    if (pool->count == pool->capacity) {
+        pool->capacity *= 2;
+        pool->offsets = (long *)realloc_w_check(pool->offsets, sizeof(long) * pool->capacity);
+        pool->hashes = (unsigned long *)realloc_w_check(pool->hashes, sizeof(unsigned long) * pool->capacity);
+    }
+    if (pool->length + length + 1 > pool->chars_capacity) {
+        while (pool->length + length + 1 > pool->chars_capacity)
+            pool->chars_capacity *= 2;
+        pool->chars = (char *)realloc_w_check(pool->chars, pool->chars_capacity);
+    }
+
+    pool->offsets[pool->count] = pool->length;
+    pool->hashes[pool->count] = hash;
+    memcpy(pool->chars + pool->length, str, length);
+    pool->chars[pool->length + length] = '\0';
+    pool->length += length + 1;
+
+    pool->slots[slot] = pool->count;
+    return pool->count++;
+}
+
+/**
+ * @brief Get the id of a string which was interned, without adding it to the pool
+ *
+ * @param pool the pool
+ * @param str the string (not null terminated)
+ * @param length the length of the string
+ * @return int the id of the string, or NOT_FOUND if it isn't in the pool
+ */
+int find_string(string_pool *pool, const char *str, long length) {
+    int slot = find_slot(pool, str, length, hash_span((char *)str, length));
+
+    return pool->slots[slot] == EMPTY_POOL_SLOT ? NOT_FOUND : pool->slots[slot];
+}
+
+/**
+ * @brief initialize an empty name map
+ *
+ * @param map the map to initialize
+ */
+void name_map_init(name_map *map) {
+    map->count = 0;
+    map->capacity = NAME_MAP_INIT_CAPACITY;
+    map->items = (int *)malloc_w_check(sizeof(int) * map->capacity);
+}
+
+/**
+ * @brief removes the values of all the ids, and keeps the memory of the map
+ *
+ * @param map the map to clear
+ */
+void name_map_reset(name_map *map) {
+    map->count = 0;
+}
+
+/**
+ * @brief free memory allocation of a given name map
+ *
+ * @param map the map to free
+ */
+void name_map_free(name_map *map) {
+    free(map->items);
+    map->items = NULL;
+    map->count = map->capacity = 0;
+}
+
+/**
+ * @param map the map
+ * @param name_id the id of a string in the pool
+ * @return int the value of the id, or NOT_FOUND if it has no value
+ */
+int name_map_get(name_map *map, int name_id) {
+    return name_id >= 0 && name_id < map->count ? map->items[name_id] : NOT_FOUND;
+}
+
+/**
+ * @brief sets the value of an id, the ids which are added to the map before it have no value
+ *
+ * @param map the map
+ * @param name_id the id of a string in the pool
+ * @param value the value of the id
+ */
+void name_map_set(name_map *map, int name_id, int value) {
+    if (name_id >= map->capacity) {
+        while (name_id >= map->capacity)
+            map->capacity *= 2;
+        map->items = (int *)realloc_w_check(map->items, sizeof(int) * map->capacity);
+    }
+    while (map->count <= name_id)
+        map->items[map->count++] = NOT_FOUND;
+    map->items[name_id] = value;
+}
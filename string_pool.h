@@ -0,0 +1,31 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "global.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define POOL_INIT_STRINGS 64      /* initial number of strings in the pool */
+#define POOL_INIT_SLOTS 128       /* initial number of slots in the hash index, must be a power of 2 */
+#define POOL_INIT_CHARS 1024      /* initial number of characters in the pool */
+#define NAME_MAP_INIT_CAPACITY 64 /* initial number of ids in a map */
+#define EMPTY_POOL_SLOT -1        /* marks a slot that was never used */
+
+/* the null terminated string of an id */
+#define POOL_STRING(pool, id) ((pool)->chars + (pool)->offsets[id])
+
+/* Prototypes */
+void pool_init(string_pool *pool);
+void pool_reset(string_pool *pool);
+void pool_free(string_pool *pool);
+int intern_string(string_pool *pool, const char *str, long length);
+int find_string(string_pool *pool, const char *str, long length);
+void name_map_init(name_map *map);
+void name_map_reset(name_map *map);
+void name_map_free(name_map *map);
+int name_map_get(name_map *map, int name_id);
+void name_map_set(name_map *map, int name_id, int value);
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * @file symbols_table.c
+ * @brief this file includes all the functions which are managing the symbols table of all labels in the source file.
+ * labels are stored in an array where the index of a label is its id. their names are interned in the pool of names
+ * of the source, and a label is found by the id of its name, so a lookup costs a single probe of the pool.
+ * a label gets its id when it is first referenced or defined, so references to labels which are defined later
+ * in the source (forward references) can be recorded by id, and resolved at the end of stage 1.
+ * each label is defined in a section (code, data or extern) with an offset in it, and its address is computed from
+ * the base of its section when it's read, so relocating the labels (e.g. to a different load base) doesn't depend on
+ * the number of labels.
+ */
+
+#include "symbols_table.h"
+#include <stdio.h>
+
+/* Prototypes */
+static int add_label(symbols_table *tbl, int name_id);
+
+/**
+ * @brief initialize an empty symbols table
+ *
+ * @param tbl the table to initialize
+ * @param names the pool which the names of the labels are interned in
+ */
+void symbols_init(symbols_table *tbl, string_pool *names) {
+    int i;
+
+    tbl->count = 0;
+    tbl->capacity = SYMBOLS_INIT_CAPACITY;
+    tbl->num_defined = 0;
+    for (i = 0; i < NUM_SECTIONS; i++)
+        tbl->section_base[i] = 0;
+    tbl->labels = (Labels *)malloc_w_check(sizeof(Labels) * tbl->capacity);
+    tbl->defined = (int *)malloc_w_check(sizeof(int) * tbl->capacity);
+    tbl->names = names;
+    name_map_init(&tbl->label_ids);
+}
+
+/**
+ * @brief removes all the labels from the table, and keeps its memory for the next source
+ *
+ * @param tbl the table to clear
+ */
+void symbols_reset(symbols_table *tbl) {
+    int i;
+
+    tbl->count = 0;
+    tbl->num_defined = 0;
+    for (i = 0; i < NUM_SECTIONS; i++)
+        tbl->section_base[i] = 0;
+    name_map_reset(&tbl->label_ids);
+}
+
+/**
+ * @brief free memory allocation of a given symbols table
+ *
+ * @param tbl the table to free
+ */
+void symbols_free(symbols_table *tbl) {
+    free(tbl->labels);
+    free(tbl->defined);
+    name_map_free(&tbl->label_ids);
+    tbl->labels = NULL;
+    tbl->defined = NULL;
+    tbl->count = tbl->num_defined = tbl->capacity = 0;
+}
+
+/**
+ * @brief appends a new undefined label to the table
+ *
+ * @param tbl the symbols table
+ * @param name_id the id of the name of the label in the pool of names
+ * @return int the id of the new label
+ */
+static int add_label(symbols_table *tbl, int name_id) {
+    label_ptr temp;
+
+    if (tbl->count == tbl->capacity) {
+        tbl->capacity *= 2;
+        tbl->labels = (Labels *)realloc_w_check(tbl->labels, sizeof(Labels) * tbl->capacity);
+        tbl->defined = (int *)realloc_w_check(tbl->defined, sizeof(int) * tbl->capacity);
+    }
+
+    temp = &tbl->labels[tbl->count];
+    temp->name_id = name_id;
+    temp->section = SECTION_DATA;
+    temp->offset = 0;
+    temp->entry = FALSE;
+    temp->defined = FALSE;
+
+    name_map_set(&tbl->label_ids, name_id, tbl->count);
+    return tbl->count++;
+}
+
+/**
+ * @brief Get the label record from the symbols table
+ *
+ * @param tbl the symbols table
+ * @param name name of the label to find (upto LABEL_MAX_LEN characters, not null terminated)
+ * @param length the length of the name
+ * @return label_ptr pointer to the label record, or NULL if it wasn't defined.
+ * the pointer is valid until the next insertion to the table.
+ */
+label_ptr get_label(symbols_table *tbl, char *name, int length) {
+    int id = name_map_get(&tbl->label_ids, find_string(tbl->names, name, length));
+
+    if (id == NOT_FOUND || !tbl->labels[id].defined)
+        return NULL;
+    return &tbl->labels[id];
+}
+
+/**
+ * @brief Get the id of a label which is referenced by the code. if the label wasn't defined or
+ * referenced yet, an undefined label is added to the table, to be defined later.
+ *
+ * @param tbl the symbols table
+ * @param name name of the label (upto LABEL_MAX_LEN characters, not null terminated)
+ * @param length the length of the name
+ * @return int the id of the label
+ */
+int reference_label(symbols_table *tbl, char *name, int length) {
+    int name_id = intern_string(tbl->names, name, length);
+    int id = name_map_get(&tbl->label_ids, name_id);
+
+    return id != NOT_FOUND ? id : add_label(tbl, name_id);
+}
+
+/**
+ * @brief function which defines a label in the symbols table
+ *
+ * @param ctx the assembler context, which holds the symbols table
+ * @param name the name of the label to insert (upto LABEL_MAX_LEN characters, not null terminated)
+ * @param length the length of the name
+ * @param section the section of the label (code, data or extern)
+ * @param offset address of the label relative to the base of its section (ignored for external labels)
+ * @return label_ptr pointer to the defined record with the given data, or NULL if the label already exists.
+ * the pointer is valid until the next insertion to the table.
+ */
+label_ptr insert_label(assembler_ctx *ctx, char *name, int length, int section, unsigned int offset) {
+    symbols_table *tbl = &ctx->symbols_tbl;
+    int name_id = intern_string(tbl->names, name, length);
+    int id = name_map_get(&tbl->label_ids, name_id);
+    label_ptr temp;
+
+    if (id == NOT_FOUND)
+        id = add_label(tbl, name_id);
+    else if (tbl->labels[id].defined) {
+        set_error(ctx, ERR_LABEL_ALREADY_EXISTS);
+        return NULL;
+    }
+
+    /* Storing the info of the label in its record */
+    temp = &tbl->labels[id];
+    temp->defined = TRUE;
+    temp->section = section;
+    temp->offset = section == SECTION_EXTERN ? 0 : offset; /* External labels have no address */
+    if (section == SECTION_EXTERN)
+        ctx->extern_exists = TRUE;
+
+    tbl->defined[tbl->num_defined++] = id;
+    return temp;
+}
+
+/**
+ * @brief merges the labels of a chunk of the source, which were collected in a separate table, to the table of the
+ * whole source. the labels of the chunk get their ids by order of their first appearance, and are defined by order of
+ * their definitions, as if the chunk was compiled after the previous ones. their offsets are relative to the chunk,
+ * so the sizes of the sections of the previous chunks are added to them.
+ *
+ * @param tbl the symbols table of the whole source
+ * @param chunk the symbols table of the chunk
+ * @param id_map array to fill with the id of each label of the chunk in the table of the whole source
+ * @param ic_base the number of instruction words before the chunk
+ * @param dc_base the number of data words before the chunk
+ * @return true if merged, false if a label of the chunk was already defined (the table is partly merged).
+ */
+bool merge_labels(symbols_table *tbl, symbols_table *chunk, int *id_map, unsigned int ic_base, unsigned int dc_base) {
+    label_ptr label, dest;
+    char *name;
+    int i;
+
+    /* the names of the chunk are interned in its own pool */
+    for (i = 0; i < chunk->count; i++) {
+        name = LABEL_NAME(chunk, &chunk->labels[i]);
+        id_map[i] = reference_label(tbl, name, (int)strlen(name));
+    }
+
+    for (i = 0; i < chunk->num_defined; i++) {
+        label = &chunk->labels[chunk->defined[i]];
+        dest = &tbl->labels[id_map[chunk->defined[i]]];
+        if (dest->defined)
+            return FALSE;
+
+        dest->defined = TRUE;
+        dest->section = label->section;
+        dest->offset = label->offset;
+        if (label->section == SECTION_CODE)
+            dest->offset += ic_base;
+        else if (label->section == SECTION_DATA)
+            dest->offset += dc_base;
+        tbl->defined[tbl->num_defined++] = id_map[chunk->defined[i]];
+    }
+    return TRUE;
+}
+
+/**
+ * @brief function which sets the label to entry.
+ *
+ * @param ctx the assembler context, which holds the symbols table
+ * @param id the id of the lable to update
+ * @return true if set successfully, otherwise false.
+ */
+bool set_label_to_entry(assembler_ctx *ctx, int id) {
+    label_ptr label;
+
+    if (id != NOT_FOUND && ctx->symbols_tbl.labels[id].defined) {
+        label = &ctx->symbols_tbl.labels[id];
+        if (label->section == SECTION_EXTERN) {
+            set_error(ctx, ERR_ENTRY_CANT_BE_EXTERN);
+            return FALSE;
+        }
+        label->entry = TRUE;
+        ctx->entry_exists = TRUE;
+        return TRUE;
+    } else
+        set_error(ctx, ERR_LABEL_DOES_NOT_EXIST);
+
+    return FALSE;
+}
+
+/**
+ * @brief function which moves the sections in memory: the code starts at the load base, and the data right after it.
+ * the addresses of the labels are computed from the bases of their sections, so no label is changed.
+ *
+ * @param tbl the symbols table
+ * @param load_base the address of the first instruction
+ * @param code_size the number of words of the instructions
+ */
+void relocate_sections(symbols_table *tbl, unsigned int load_base, unsigned int code_size) {
+    tbl->section_base[SECTION_CODE] = load_base;
+    tbl->section_base[SECTION_DATA] = load_base + code_size;
+    tbl->section_base[SECTION_EXTERN] = 0;
+}
+
+/**
+ * @param tbl the symbols table
+ * @param label a defined label
+ * @return unsigned int the address of the label in memory (0 for an external label)
+ */
+unsigned int label_address(symbols_table *tbl, label_ptr label) {
+    return tbl->section_base[label->section] + label->offset;
+}
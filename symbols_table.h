@@ -0,0 +1,29 @@
+#ifndef SYMBOLS_TABLE_H
+#define SYMBOLS_TABLE_H
+
+#include "global.h"
+#include "string_pool.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Declarations */
+#define SYMBOLS_INIT_CAPACITY 64 /* initial length of the labels array */
+
+/* the null terminated name of a label */
+#define LABEL_NAME(tbl, label) POOL_STRING((tbl)->names, (label)->name_id)
+
+/* Prototypes */
+void symbols_init(symbols_table *tbl, string_pool *names);
+void symbols_reset(symbols_table *tbl);
+void symbols_free(symbols_table *tbl);
+label_ptr get_label(symbols_table *tbl, char *name, int length);
+int reference_label(symbols_table *tbl, char *name, int length);
+label_ptr insert_label(assembler_ctx *ctx, char *name, int length, int section, unsigned int offset);
+bool merge_labels(symbols_table *tbl, symbols_table *chunk, int *id_map, unsigned int ic_base, unsigned int dc_base);
+bool set_label_to_entry(assembler_ctx *ctx, int id);
+void relocate_sections(symbols_table *tbl, unsigned int load_base, unsigned int code_size);
+unsigned int label_address(symbols_table *tbl, label_ptr label);
+
+#endif
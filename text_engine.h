@@ -2,22 +2,14 @@
 #define TEXT_ENGINE_H
 
 #include "global.h"
+#include "keywords.h"
 #include "utils.h"
 #include <ctype.h>
 #include <string.h>
 
 /* Prototypes */
-char *skip_spaces(char *);
-bool is_ignore_line(char *);
-bool is_reserved_word(char *);
-bool is_register(char *);
-void copy_word(char *word, char *line);
-char *next_word(char *);
-bool is_end_of_line(char *);
-bool is_label(char *word, bool is_w_colon);
-char *copy_next_li_word(char *dest, char *line);
-bool is_number(char *str);
-bool is_string(char *str);
-char *next_token_string(char *dest, char *line);
+bool is_reserved_word(char *word, int length);
+bool is_register(char *word, int length);
+bool is_label(assembler_ctx *ctx, char *word, int word_len, bool is_w_colon);
 
 #endif
@@ -5,24 +5,94 @@
  */
 
 #include "utils.h"
+#include "arena.h"
+#include "memory_image.h"
 #include <ctype.h>
-#include <math.h>
-#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* The base32 digits of global.c (base32[]) as character constants, for building the table below */
+#define B32_0 '!'
+#define B32_1 '@'
+#define B32_2 '#'
+#define B32_3 '$'
+#define B32_4 '%'
+#define B32_5 '^'
+#define B32_6 '&'
+#define B32_7 '*'
+#define B32_8 '<'
+#define B32_9 '>'
+#define B32_10 'a'
+#define B32_11 'b'
+#define B32_12 'c'
+#define B32_13 'd'
+#define B32_14 'e'
+#define B32_15 'f'
+#define B32_16 'g'
+#define B32_17 'h'
+#define B32_18 'i'
+#define B32_19 'j'
+#define B32_20 'k'
+#define B32_21 'l'
+#define B32_22 'm'
+#define B32_23 'n'
+#define B32_24 'o'
+#define B32_25 'p'
+#define B32_26 'q'
+#define B32_27 'r'
+#define B32_28 's'
+#define B32_29 't'
+#define B32_30 'u'
+#define B32_31 'v'
+
+#define B32_PAIR(h, l) {B32_##h, B32_##l}
+#define B32_ROW(h)                                                                                  \
+    B32_PAIR(h, 0), B32_PAIR(h, 1), B32_PAIR(h, 2), B32_PAIR(h, 3), B32_PAIR(h, 4), B32_PAIR(h, 5),     \
+        B32_PAIR(h, 6), B32_PAIR(h, 7), B32_PAIR(h, 8), B32_PAIR(h, 9), B32_PAIR(h, 10),                \
+        B32_PAIR(h, 11), B32_PAIR(h, 12), B32_PAIR(h, 13), B32_PAIR(h, 14), B32_PAIR(h, 15),            \
+        B32_PAIR(h, 16), B32_PAIR(h, 17), B32_PAIR(h, 18), B32_PAIR(h, 19), B32_PAIR(h, 20),            \
+        B32_PAIR(h, 21), B32_PAIR(h, 22), B32_PAIR(h, 23), B32_PAIR(h, 24), B32_PAIR(h, 25),            \
+        B32_PAIR(h, 26), B32_PAIR(h, 27), B32_PAIR(h, 28), B32_PAIR(h, 29), B32_PAIR(h, 30), B32_PAIR(h, 31)
+
+/* The 2 digits encoding of every 10 bits word: high 5 bits, then low 5 bits */
+static const char base32_words[BASE32_TABLE_SIZE][BASE32_WORD_LENGTH] = {
+    B32_ROW(0), B32_ROW(1), B32_ROW(2), B32_ROW(3), B32_ROW(4), B32_ROW(5), B32_ROW(6), B32_ROW(7),
+    B32_ROW(8), B32_ROW(9), B32_ROW(10), B32_ROW(11), B32_ROW(12), B32_ROW(13), B32_ROW(14), B32_ROW(15),
+    B32_ROW(16), B32_ROW(17), B32_ROW(18), B32_ROW(19), B32_ROW(20), B32_ROW(21), B32_ROW(22), B32_ROW(23),
+    B32_ROW(24), B32_ROW(25), B32_ROW(26), B32_ROW(27), B32_ROW(28), B32_ROW(29), B32_ROW(30), B32_ROW(31)};
 
 /**
- * Concatenates both string to a new allocated memory
- * @param s0 The first string
- * @param s1 The second string
- * @return A pointer to the new, allocated string
+ * Calculates the hash of a null terminated string (FNV-1a), for hash tables of names.
+ * @param str The string
+ * @return The hash of the string (32 bits)
  */
-char *str_alloc_concat(char *s0, char *s1) {
-    char *str = (char *)malloc_w_check(strlen(s0) + strlen(s1) + 1);
-    strcpy(str, s0);
-    strcat(str, s1);
-    return str;
+unsigned long hash_string(char *str) {
+    unsigned long hash = 2166136261UL;
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+/**
+ * Calculates the hash of a span of a string (not null terminated), same as hash_string of the span.
+ * @param str The first character of the span
+ * @param length The length of the span
+ * @return The hash of the span (32 bits)
+ */
+unsigned long hash_span(char *str, long length) {
+    unsigned long hash = 2166136261UL;
+    while (length-- > 0) {
+        hash ^= (unsigned char)*str++;
+        hash = (hash * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
 }
 
 /**
@@ -39,37 +109,47 @@ void *malloc_w_check(long size) {
     return ptr;
 }
 
+/**
+ * Reallocates memory to the required size. Exits the program if failed.
+ * @param ptr The memory to reallocate
+ * @param size The new size in bytes
+ * @return A generic pointer to the reallocated memory if succeeded
+ */
+void *realloc_w_check(void *ptr, long size) {
+    ptr = realloc(ptr, size);
+    if (ptr == NULL) {
+        printf("Error: Fatal: Memory allocation failed.");
+        exit(1);
+    }
+    return ptr;
+}
+
 /**
  * @brief function which insert a number to the data_memory
  *
+ * @param ctx the assembler context
  * @param number the number to insert
  */
-void write_num_to_data_memory(int number) {
-    data_memory[dc++] = (unsigned int)number;
+void write_num_to_data_memory(assembler_ctx *ctx, int number) {
+    image_reserve(&ctx->data_memory, ctx->dc + 1);
+    ctx->data_memory.words[ctx->dc++] = (machine_word)number;
 }
 
-/* This function encodes a given string to data */
+/* This function encodes the characters of a given string to data */
 /**
- * @brief function which write a string to the data_memory
+ * @brief function which write the characters of a string to the data_memory, without closing the string.
  * note: each character is a 'word' 10 bits as in the booklet.
  *
- * @param str the string to insert to data_memory
+ * @param ctx the assembler context
+ * @param str the characters to insert to data_memory
+ * @param length the number of characters
  */
-void write_string_to_data_memory(char *str) {
-    while (!is_end_of_line(str)) {
-        data_memory[dc++] = (unsigned int)*str;
+void write_string_to_data_memory(assembler_ctx *ctx, char *str, int length) {
+    image_reserve(&ctx->data_memory, ctx->dc + length);
+    while (length-- > 0) {
+        ctx->data_memory.words[ctx->dc++] = (machine_word)*str;
         str++;
     }
-    data_memory[dc++] = '\0'; /* close string */
-}
-
-/**
- * @brief function which inserts a given word to the instructions_memory
- *
- * @param word the word to insert to memory
- */
-void write_to_instructions_memory(unsigned int word) {
-    instr_memory[ic++] = word;
 }
 
 /**
@@ -84,74 +164,29 @@ unsigned int inject_ARE(unsigned int info, int ARE) {
 }
 
 /**
- * @brief function which gets a number which represents a word and convert it to 2 digits in base 32.
+ * @brief function which gets a number which represents a word and encodes it as 2 digits in base 32.
+ * the encoding of every 10 bits word is taken from a precomputed table.
  *
- * @param num the number to convert
- * @return pointer to a string which represents the new converted base 32 word.
+ * @param num the number to convert (only its 10 low bits are encoded)
+ * @param dest destination to write the 2 digits to (not null terminated)
  */
-char *convert_to_base_32(unsigned int num) {
-    char *base32_token = (char *)malloc_w_check(BASE32_SEQUENCE_LENGTH);
-
-    /* convert five bits at a time to letter in 32 base */
-    base32_token[0] = base32[extract_bits(num, 5, 9)];
-    base32_token[1] = base32[extract_bits(num, 0, 4)];
-    base32_token[2] = '\0';
-
-    return base32_token;
-}
-
-/**
- * @brief function which cuts a word which represents a number, and return the cutted number
- *
- * @param word word to cut
- * @param start starting index
- * @param end  end index
- * @return unsigned int which represents a number
- */
-unsigned int extract_bits(unsigned int word, int start, int end) {
-    unsigned int result;
-    int length = end - start + 1;                /* Length of bit-sequence */
-    unsigned int mask = (int)pow(2, length) - 1; /* Creating a '111...1' mask with above line's length */
-
-    mask <<= start;       /* Moving mask to place of extraction */
-    result = word & mask; /* The bits are now in their original position, and the rest is 0's */
-    result >>= start;     /* Moving the sequence to LSB */
-    return result;
-}
-
-/**
- * @brief Create a file object with a given filename and type
- *
- * @param filename the file name of the new file to create
- * @param type the type of the file, the end extension filename, such as FILE_MACRO.
- * @return FILE* returns a pointer to the new file
- */
-FILE *create_file(char *filename, int type) {
-    FILE *fd;
-    char *filename_w_ext;
-    /* Creating filename with extension */
-    filename_w_ext = generate_file_name(filename, type);
-
-    fd = fopen(filename_w_ext, "w");
-    free(filename_w_ext);
-
-    if (fd == NULL) {
-        printf("Failed creating file");
-        return NULL;
-    }
-    return fd;
+void encode_base_32(unsigned int num, char *dest) {
+    const char *digits = base32_words[num & (BASE32_TABLE_SIZE - 1)];
+    dest[0] = digits[0];
+    dest[1] = digits[1];
 }
 
 /**
  * @brief function which concatenating filename with a given type of file
  *
+ * @param temps the arena to allocate the new name from, it's valid until the arena is reset
  * @param original filename to concat
  * @param type the type of the file to add it's extension to the filename
  * @return char* pointer to the string which will represent the filename
  */
-char *generate_file_name(char *original, int type) {
+char *generate_file_name(arena *temps, char *original, int type) {
     char *new_name;
-    new_name = (char *)malloc_w_check(strlen(original) + EXT_MAX_LEN);
+    new_name = (char *)arena_alloc(temps, (long)strlen(original) + EXT_MAX_LEN);
     strcpy(new_name, original);
 
     /* concat file extension */
@@ -179,33 +214,118 @@ char *generate_file_name(char *original, int type) {
 }
 
 /**
- * @brief search index for a given directive name in directive array
+ * @brief initialize an empty text buffer
  *
- * @param word the directive to check
- * @return int directive index in array. NOT_FOUND if not found (-1)
- */
-int find_directive(char *word) {
-    int i;
-    for (i = 0; i < NUM_DIRECTIVES; i++) {
-        if (!strcmp(directives[i], word))
-            return i;
+ * @param buf the buffer to initialize
+ */
+void text_buffer_init(text_buffer *buf) {
+    buf->length = 0;
+    buf->capacity = TEXT_BUFFER_INIT_CAPACITY;
+    buf->data = (char *)malloc_w_check(buf->capacity);
+    buf->data[0] = '\0';
+}
+
+/**
+ * @brief free memory allocation of a given text buffer
+ *
+ * @param buf the buffer to free
+ */
+void text_buffer_free(text_buffer *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->length = buf->capacity = 0;
+}
+
+/**
+ * @brief makes sure that the buffer has room to append the given length (and the null terminator)
+ *
+ * @param buf the buffer
+ * @param len the length which is going to be appended
+ */
+void text_buffer_reserve(text_buffer *buf, long len) {
+    if (buf->length + len + 1 > buf->capacity) {
+        while (buf->length + len + 1 > buf->capacity)
+            buf->capacity *= 2;
+        buf->data = (char *)realloc_w_check(buf->data, buf->capacity);
     }
+}
 
-    return NOT_FOUND;
+/**
+ * @brief appends a given text to the end of the buffer, the buffer grows as needed.
+ *
+ * @param buf the buffer to append to
+ * @param str the text to append
+ * @param len length of the text
+ */
+void text_buffer_append(text_buffer *buf, char *str, long len) {
+    text_buffer_reserve(buf, len);
+    memcpy(buf->data + buf->length, str, len);
+    buf->length += len;
+    buf->data[buf->length] = '\0';
 }
 
 /**
- * @brief search index for a given command name in commands array
+ * @brief opens a source file, and makes its whole content available in memory.
+ * a regular file is mapped to memory (so it isn't copied), and anything else (e.g. a pipe) is read at once.
  *
- * @param word the command to check
- * @return int command index in array. NOT_FOUND if not found (-1)
- */
-int find_command(char *word) {
-    int i;
-    for (i = 0; i < NUM_COMMANDS; i++) {
-        if (!strcmp(commands[i], word))
-            return i;
+ * @param src the source to open, must be closed with source_close if opened
+ * @param filename the name of the file
+ * @return SUCCESS if the whole file is in memory, FAILED if it can't be opened or read
+ */
+status source_open(source_file *src, char *filename) {
+    struct stat info;
+    void *map;
+    long count;
+    int fd = open(filename, O_RDONLY);
+
+    src->data = NULL;
+    src->length = 0;
+    src->mapped = FALSE;
+    if (fd < 0)
+        return FAILED;
+
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            src->data = (char *)map;
+            src->length = info.st_size;
+            src->mapped = TRUE;
+            close(fd);
+            return SUCCESS;
+        }
     }
 
-    return NOT_FOUND;
+    /* the file can't be mapped, read it in large chunks */
+    text_buffer_init(&src->buffer);
+    do {
+        text_buffer_reserve(&src->buffer, TEXT_BUFFER_INIT_CAPACITY);
+        count = read(fd, src->buffer.data + src->buffer.length, src->buffer.capacity - src->buffer.length - 1);
+        if (count > 0)
+            src->buffer.length += count;
+    } while (count > 0);
+    close(fd);
+
+    src->buffer.data[src->buffer.length] = '\0';
+    src->data = src->buffer.data;
+    src->length = src->buffer.length;
+    if (count < 0) {
+        source_close(src);
+        return FAILED;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief releases the memory of a source file which was opened with source_open
+ *
+ * @param src the source to close
+ */
+void source_close(source_file *src) {
+    if (src->mapped)
+        munmap(src->data, src->length);
+    else
+        text_buffer_free(&src->buffer);
+    src->data = NULL;
+    src->length = 0;
+    src->mapped = FALSE;
 }
@@ -7,7 +7,9 @@
 
 /* Declarations */
 #define ERR_OUTPUT_FILE stderr
-#define BASE32_SEQUENCE_LENGTH 3
+#define BASE32_WORD_LENGTH 2   /* a word is encoded as 2 digits in base 32 */
+#define BASE32_TABLE_SIZE 1024 /* number of 10 bits words */
+#define TEXT_BUFFER_INIT_CAPACITY 4096
 
 enum filetypes { FILE_INPUT,
                  FILE_MACRO,
@@ -16,17 +18,20 @@ enum filetypes { FILE_INPUT,
                  FILE_EXTERN };
 
 /* Prototypes */
-char *str_alloc_concat(char *s0, char *s1);
+unsigned long hash_string(char *str);
+unsigned long hash_span(char *str, long length);
 void *malloc_w_check(long size);
-void write_num_to_data_memory(int number);
-void write_string_to_data_memory(char *str);
-void write_to_instructions_memory(unsigned int word);
+void *realloc_w_check(void *ptr, long size);
+void write_num_to_data_memory(assembler_ctx *ctx, int number);
+void write_string_to_data_memory(assembler_ctx *ctx, char *str, int length);
 unsigned int inject_ARE(unsigned int info, int are);
-char *convert_to_base_32(unsigned int num);
-unsigned int extract_bits(unsigned int word, int start, int end);
-FILE *create_file(char *filename, int type);
-char *generate_file_name(char *original, int type);
-int find_directive(char *word);
-int find_command(char *word);
+void encode_base_32(unsigned int num, char *dest);
+void text_buffer_init(text_buffer *buf);
+void text_buffer_free(text_buffer *buf);
+void text_buffer_append(text_buffer *buf, char *str, long len);
+void text_buffer_reserve(text_buffer *buf, long len);
+status source_open(source_file *src, char *filename);
+void source_close(source_file *src);
+char *generate_file_name(arena *temps, char *original, int type);
 
 #endif